@@ -3,6 +3,8 @@
 # include <stdlib.h>
 # include <stdint.h>
 # include <stdbool.h>
+# include <pthread.h>
+# include <stdatomic.h>
 
 typedef struct lagus_memory_management {
     void * (* allocate) (uint64_t, uint64_t);
@@ -23,6 +25,55 @@ typedef enum lagus_result {
 # define lagus_left 0
 # define lagus_right 1
 # define lagus_one ((__uint128_t) 1)
+# define lagus_union 0
+# define lagus_intersection 1
+# define lagus_difference 2
+
+static inline uint64_t lagus_load_word (uint8_t * bytes) {
+    uint64_t word;
+    __builtin_memcpy (& word, bytes, sizeof (uint64_t));
+# if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64 (word);
+# endif
+    return word;
+}
+
+static inline int64_t lagus_binary_compare (uint8_t * bytes_a, uint8_t * bytes_b, uint64_t size) {
+    while (size >= sizeof (uint64_t)) {
+        size -= sizeof (uint64_t);
+        uint64_t word_a = lagus_load_word (bytes_a + size);
+        uint64_t word_b = lagus_load_word (bytes_b + size);
+        if (word_a < word_b)
+            return -1;
+        if (word_a > word_b)
+            return 1;
+    }
+    while (size) {
+        size --;
+        if (bytes_a [size] < bytes_b [size])
+            return -1;
+        if (bytes_a [size] > bytes_b [size])
+            return 1;
+    }
+    return 0;
+}
+
+static inline uint64_t lagus_bytes_prefix (uint8_t * bytes, uint64_t size) {
+    uint64_t prefix = 0;
+    for (uint64_t index = 0; index < sizeof (uint64_t); index ++) {
+        prefix <<= 8;
+        if (index < size)
+            prefix |= bytes [index];
+    }
+    return prefix;
+}
+
+static inline uint64_t lagus_random (uint64_t * state) {
+    uint64_t value = * state += 0x9E3779B97F4A7C15;
+    value = (value ^ value >> 30) * 0xBF58476D1CE4E5B9;
+    value = (value ^ value >> 27) * 0x94D049BB133111EB;
+    return value ^ value >> 31;
+}
 
 /* List */
 
@@ -1171,105 +1222,476 @@ lagus_result lagus_list_iterator_##E##_finalize (lagus_list_iterator_##E * itera
 
 /* BST */
 
+# define lagus_bst_batch_width 16
+
+# define lagus_bst_no_update(buffer, node)
+
 // Declaration
 
-# define lagus_declare_bst(E) \
-\
-typedef int64_t (* lagus_compare_##E) (E, E);\
+# define lagus_declare_bst_nodes(E, T, N) \
 \
-typedef struct lagus_bst_node_##E {\
+typedef struct lagus_##T##_node_##E {\
     uint64_t parent;\
     uint64_t left_child;\
     uint64_t right_child;\
     uint64_t size;\
     uint8_t configuration;\
+    N\
     E element;\
-} lagus_bst_node_##E;\
+} lagus_##T##_node_##E;
+
+# define lagus_declare_bst_named(E, T, N) \
 \
-typedef struct lagus_bst_##E {\
+lagus_declare_bst_nodes(E, T, N)\
+\
+typedef struct lagus_##T##_##E {\
     uint64_t height;\
     uint64_t capacity;\
-    lagus_bst_node_##E * buffer;\
+    uint64_t modifications;\
+    lagus_##T##_node_##E * buffer;\
     lagus_compare_##E compare;\
     lagus_memory_management memory_management;\
-} lagus_bst_##E;\
+} lagus_##T##_##E;\
+\
+typedef struct lagus_##T##_relayout_cursor_##E {\
+    uint64_t position;\
+    uint64_t modifications;\
+} lagus_##T##_relayout_cursor_##E;\
 \
-typedef struct lagus_bst_iterator_##E {\
+typedef struct lagus_##T##_iterator_##E {\
     __uint128_t index;\
     uint64_t height;\
     uint64_t node;\
-    lagus_bst_node_##E * buffer;\
-} lagus_bst_iterator_##E;\
+    lagus_##T##_node_##E * buffer;\
+} lagus_##T##_iterator_##E;\
 \
-int64_t lagus_binary_compare_##E (E a, E b);\
+typedef struct lagus_##T##_range_iterator_##E {\
+    lagus_##T##_iterator_##E iterator;\
+    lagus_##T##_##E * bst;\
+    bool bounded;\
+    E upper;\
+} lagus_##T##_range_iterator_##E;\
+\
+typedef struct lagus_frozen_##T##_##E {\
+    uint64_t size;\
+    E * buffer;\
+    lagus_compare_##E compare;\
+    lagus_memory_management memory_management;\
+} lagus_frozen_##T##_##E;\
+\
+lagus_result lagus_##T##_##E##_initialize (lagus_##T##_##E * bst);\
+\
+lagus_result lagus_##T##_##E##_custom_initialize (lagus_##T##_##E * bst, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_##T##_##E##_finalize (lagus_##T##_##E * bst);\
+\
+lagus_result lagus_##T##_##E##_size (lagus_##T##_##E * bst, uint64_t * size);\
+\
+lagus_result lagus_##T##_##E##_add_left (lagus_##T##_##E * bst, E element);\
+\
+lagus_result lagus_##T##_##E##_add_right (lagus_##T##_##E * bst, E element);\
+\
+lagus_result lagus_##T##_##E##_add_right_hint (lagus_##T##_##E * bst, uint64_t index, E element);\
+\
+lagus_result lagus_##T##_##E##_add_at (lagus_##T##_##E * bst, uint64_t index, E element);\
+\
+lagus_result lagus_##T##_##E##_build_sorted (lagus_##T##_##E * bst, E * elements, uint64_t size);\
+\
+lagus_result lagus_##T##_##E##_build_parallel (lagus_##T##_##E * bst, E * elements, uint64_t size, uint64_t threads);\
 \
-lagus_result lagus_bst_##E##_initialize (lagus_bst_##E * bst);\
+lagus_result lagus_##T##_##E##_add_batch_left (lagus_##T##_##E * bst, E * elements, uint64_t size);\
 \
-lagus_result lagus_bst_##E##_custom_initialize (lagus_bst_##E * bst, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management);\
+lagus_result lagus_##T##_##E##_add_batch_right (lagus_##T##_##E * bst, E * elements, uint64_t size);\
 \
-lagus_result lagus_bst_##E##_finalize (lagus_bst_##E * bst);\
+lagus_result lagus_##T##_##E##_search_left (lagus_##T##_##E * bst, E * element, uint64_t * index);\
 \
-lagus_result lagus_bst_##E##_size (lagus_bst_##E * bst, uint64_t * size);\
+lagus_result lagus_##T##_##E##_search_right (lagus_##T##_##E * bst, E * element, uint64_t * index);\
 \
-lagus_result lagus_bst_##E##_add_left (lagus_bst_##E * bst, E element);\
+lagus_result lagus_##T##_##E##_search_batch_left (lagus_##T##_##E * bst, E * elements, uint64_t * indices, lagus_result * results, uint64_t size);\
 \
-lagus_result lagus_bst_##E##_add_right (lagus_bst_##E * bst, E element);\
+lagus_result lagus_##T##_##E##_search_batch_right (lagus_##T##_##E * bst, E * elements, uint64_t * indices, lagus_result * results, uint64_t size);\
 \
-lagus_result lagus_bst_##E##_add_at (lagus_bst_##E * bst, uint64_t index, E element);\
+lagus_result lagus_##T##_##E##_search_floor (lagus_##T##_##E * bst, E * element, uint64_t * index);\
 \
-lagus_result lagus_bst_##E##_search_left (lagus_bst_##E * bst, E * element, uint64_t * index);\
+lagus_result lagus_##T##_##E##_search_ceiling (lagus_##T##_##E * bst, E * element, uint64_t * index);\
 \
-lagus_result lagus_bst_##E##_search_right (lagus_bst_##E * bst, E * element, uint64_t * index);\
+lagus_result lagus_##T##_##E##_search_predecessor (lagus_##T##_##E * bst, E * element, uint64_t * index);\
 \
-lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element);\
+lagus_result lagus_##T##_##E##_search_successor (lagus_##T##_##E * bst, E * element, uint64_t * index);\
 \
-lagus_result lagus_bst_##E##_remove_right (lagus_bst_##E * bst, E * element);\
+lagus_result lagus_##T##_##E##_rank_left (lagus_##T##_##E * bst, E * element, uint64_t * index);\
 \
-lagus_result lagus_bst_##E##_remove_at (lagus_bst_##E * bst, uint64_t index, E * element);\
+lagus_result lagus_##T##_##E##_rank_right (lagus_##T##_##E * bst, E * element, uint64_t * index);\
 \
-lagus_result lagus_bst_##E##_get_at (lagus_bst_##E * bst, uint64_t index, E * element);\
+lagus_result lagus_##T##_##E##_count_range (lagus_##T##_##E * bst, E * lower, E * upper, uint64_t * count);\
 \
-lagus_result lagus_bst_##E##_set_at (lagus_bst_##E * bst, uint64_t index, E * element);\
+lagus_result lagus_##T##_##E##_sample_distinct (lagus_##T##_##E * bst, uint64_t * state, E * elements, uint64_t count);\
+\
+lagus_result lagus_##T##_##E##_remove_left (lagus_##T##_##E * bst, E * element);\
+\
+lagus_result lagus_##T##_##E##_remove_right (lagus_##T##_##E * bst, E * element);\
+\
+lagus_result lagus_##T##_##E##_remove_at (lagus_##T##_##E * bst, uint64_t index, E * element);\
+\
+lagus_result lagus_##T##_##E##_remove_range (lagus_##T##_##E * bst, E * lower, E * upper, E * elements, uint64_t * count);\
+\
+lagus_result lagus_##T##_##E##_remove_range_at (lagus_##T##_##E * bst, uint64_t first, uint64_t last, E * elements);\
+\
+lagus_result lagus_##T##_##E##_get_at (lagus_##T##_##E * bst, uint64_t index, E * element);\
+\
+lagus_result lagus_##T##_##E##_set_at (lagus_##T##_##E * bst, uint64_t index, E * element);\
+\
+lagus_result lagus_##T##_##E##_split_left (lagus_##T##_##E * bst, E * element, lagus_##T##_##E * other);\
+\
+lagus_result lagus_##T##_##E##_split_right (lagus_##T##_##E * bst, E * element, lagus_##T##_##E * other);\
+\
+lagus_result lagus_##T##_##E##_split_at (lagus_##T##_##E * bst, uint64_t index, lagus_##T##_##E * other);\
+\
+lagus_result lagus_##T##_##E##_join (lagus_##T##_##E * bst, lagus_##T##_##E * other);\
+\
+lagus_result lagus_##T##_##E##_union (lagus_##T##_##E * bst, lagus_##T##_##E * other, lagus_##T##_##E * result, uint64_t threads);\
+\
+lagus_result lagus_##T##_##E##_intersection (lagus_##T##_##E * bst, lagus_##T##_##E * other, lagus_##T##_##E * result, uint64_t threads);\
+\
+lagus_result lagus_##T##_##E##_difference (lagus_##T##_##E * bst, lagus_##T##_##E * other, lagus_##T##_##E * result, uint64_t threads);\
+\
+lagus_result lagus_##T##_##E##_relayout (lagus_##T##_##E * bst);\
+\
+lagus_result lagus_##T##_##E##_relayout_step (lagus_##T##_##E * bst, lagus_##T##_relayout_cursor_##E * cursor, uint64_t steps);\
+\
+lagus_result lagus_##T##_iterator_##E##_initialize (lagus_##T##_iterator_##E * iterator, lagus_##T##_##E * bst);\
+\
+lagus_result lagus_##T##_iterator_##E##_next (lagus_##T##_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_##T##_iterator_##E##_finalize (lagus_##T##_iterator_##E * iterator);\
+\
+lagus_result lagus_##T##_range_iterator_##E##_initialize (lagus_##T##_range_iterator_##E * iterator, lagus_##T##_##E * bst, E * lower, E * upper);\
+\
+lagus_result lagus_##T##_range_iterator_##E##_next (lagus_##T##_range_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_##T##_range_iterator_##E##_finalize (lagus_##T##_range_iterator_##E * iterator);\
+\
+lagus_result lagus_##T##_##E##_freeze (lagus_##T##_##E * bst, lagus_frozen_##T##_##E * frozen);\
+\
+lagus_result lagus_frozen_##T##_##E##_finalize (lagus_frozen_##T##_##E * frozen);\
+\
+lagus_result lagus_frozen_##T##_##E##_size (lagus_frozen_##T##_##E * frozen, uint64_t * size);\
+\
+lagus_result lagus_frozen_##T##_##E##_search_left (lagus_frozen_##T##_##E * frozen, E * element, uint64_t * index);\
+\
+lagus_result lagus_frozen_##T##_##E##_search_right (lagus_frozen_##T##_##E * frozen, E * element, uint64_t * index);\
+\
+lagus_result lagus_frozen_##T##_##E##_rank_left (lagus_frozen_##T##_##E * frozen, E * element, uint64_t * index);\
+\
+lagus_result lagus_frozen_##T##_##E##_rank_right (lagus_frozen_##T##_##E * frozen, E * element, uint64_t * index);\
+\
+lagus_result lagus_frozen_##T##_##E##_get_at (lagus_frozen_##T##_##E * frozen, uint64_t index, E * element);
+
+# define lagus_declare_bst(E) \
 \
-lagus_result lagus_bst_iterator_##E##_initialize (lagus_bst_iterator_##E * iterator, lagus_bst_##E * bst);\
+typedef int64_t (* lagus_compare_##E) (E, E);\
 \
-lagus_result lagus_bst_iterator_##E##_next (lagus_bst_iterator_##E * iterator, E * element);\
+int64_t lagus_binary_compare_##E (E a, E b);\
 \
-lagus_result lagus_bst_iterator_##E##_finalize (lagus_bst_iterator_##E * iterator);
+lagus_declare_bst_named(E, bst, )
 
 // Implementation
 
-# define lagus_implement_bst(E) \
+# define lagus_implement_bst_nodes(E, T, U, P) \
 \
-int64_t lagus_binary_compare_##E (E a, E b) {\
-    uint8_t * bytes_a = (uint8_t *) & a;\
-    uint8_t * bytes_b = (uint8_t *) & b;\
-    uint64_t index = sizeof (E) - 1;\
+static uint64_t lagus_##T##_##E##_balanced_height (uint64_t size) {\
+    uint64_t height = 0;\
+    while (size) {\
+        size >>= 1;\
+        height ++;\
+    }\
+    return height;\
+}\
+\
+static void lagus_##T##_##E##_build_subtree (lagus_##T##_node_##E * buffer, E * elements, uint64_t size, uint64_t node, uint64_t parent) {\
+    uint64_t left_size = size - 1 >> 1;\
+    uint64_t right_size = size - 1 - left_size;\
+    buffer [node] = (lagus_##T##_node_##E) {\
+        .parent = parent,\
+        .left_child = lagus_none,\
+        .right_child = lagus_none,\
+        .size = size,\
+        .configuration = 0b00,\
+        .element = elements [left_size]\
+    };\
+    if (right_size != left_size && ! (right_size & right_size - 1))\
+        buffer [node].configuration = 0b01;\
+    if (left_size) {\
+        buffer [node].left_child = node + 1;\
+        lagus_##T##_##E##_build_subtree (buffer, elements, left_size, node + 1, node);\
+    }\
+    if (right_size) {\
+        buffer [node].right_child = node + left_size + 1;\
+        lagus_##T##_##E##_build_subtree (buffer, elements + left_size + 1, right_size, node + left_size + 1, node);\
+    }\
+    U (buffer, node);\
+}\
+\
+static E * lagus_##T##_##E##_flatten (lagus_##T##_node_##E * buffer, uint64_t node, E * output) {\
+    while (node) {\
+        P (buffer, node);\
+        output = lagus_##T##_##E##_flatten (buffer, buffer [node].left_child, output);\
+        * output = buffer [node].element;\
+        output ++;\
+        node = buffer [node].right_child;\
+    }\
+    return output;\
+}\
+\
+static void lagus_##T##_##E##_child_heights (lagus_##T##_node_##E * buffer, uint64_t node, uint64_t height, uint64_t * left_height, uint64_t * right_height) {\
+    P (buffer, node);\
+    * left_height = height - 1;\
+    * right_height = height - 1;\
+    if (buffer [node].configuration == 0b10)\
+        (* right_height) --;\
+    else if (buffer [node].configuration == 0b01)\
+        (* left_height) --;\
+}\
+\
+static uint64_t lagus_##T##_##E##_make (lagus_##T##_node_##E * buffer, uint64_t left, uint64_t left_height, uint64_t node, uint64_t right, uint64_t right_height) {\
+    buffer [node].left_child = left;\
+    buffer [node].right_child = right;\
+    buffer [node].size = 1;\
+    if (left) {\
+        buffer [left].parent = node;\
+        buffer [node].size += buffer [left].size;\
+    }\
+    if (right) {\
+        buffer [right].parent = node;\
+        buffer [node].size += buffer [right].size;\
+    }\
+    U (buffer, node);\
+    if (left_height > right_height) {\
+        buffer [node].configuration = 0b10;\
+        return left_height + 1;\
+    }\
+    if (left_height < right_height) {\
+        buffer [node].configuration = 0b01;\
+        return right_height + 1;\
+    }\
+    buffer [node].configuration = 0b00;\
+    return left_height + 1;\
+}\
+\
+static uint64_t lagus_##T##_##E##_balance_right (lagus_##T##_node_##E * buffer, uint64_t left, uint64_t left_height, uint64_t node, uint64_t right, uint64_t right_height, uint64_t * height) {\
+    if (right_height <= left_height + 1) {\
+        * height = lagus_##T##_##E##_make (buffer, left, left_height, node, right, right_height);\
+        return node;\
+    }\
+    uint64_t a_height, b_height;\
+    lagus_##T##_##E##_child_heights (buffer, right, right_height, & a_height, & b_height);\
+    uint64_t a = buffer [right].left_child;\
+    uint64_t b = buffer [right].right_child;\
+    if (b_height >= a_height) {\
+        uint64_t height_left = lagus_##T##_##E##_make (buffer, left, left_height, node, a, a_height);\
+        * height = lagus_##T##_##E##_make (buffer, node, height_left, right, b, b_height);\
+        return right;\
+    }\
+    uint64_t c_height, d_height;\
+    lagus_##T##_##E##_child_heights (buffer, a, a_height, & c_height, & d_height);\
+    uint64_t c = buffer [a].left_child;\
+    uint64_t d = buffer [a].right_child;\
+    uint64_t height_left = lagus_##T##_##E##_make (buffer, left, left_height, node, c, c_height);\
+    uint64_t height_right = lagus_##T##_##E##_make (buffer, d, d_height, right, b, b_height);\
+    * height = lagus_##T##_##E##_make (buffer, node, height_left, a, right, height_right);\
+    return a;\
+}\
+\
+static uint64_t lagus_##T##_##E##_balance_left (lagus_##T##_node_##E * buffer, uint64_t left, uint64_t left_height, uint64_t node, uint64_t right, uint64_t right_height, uint64_t * height) {\
+    if (left_height <= right_height + 1) {\
+        * height = lagus_##T##_##E##_make (buffer, left, left_height, node, right, right_height);\
+        return node;\
+    }\
+    uint64_t a_height, b_height;\
+    lagus_##T##_##E##_child_heights (buffer, left, left_height, & a_height, & b_height);\
+    uint64_t a = buffer [left].left_child;\
+    uint64_t b = buffer [left].right_child;\
+    if (a_height >= b_height) {\
+        uint64_t height_right = lagus_##T##_##E##_make (buffer, b, b_height, node, right, right_height);\
+        * height = lagus_##T##_##E##_make (buffer, a, a_height, left, node, height_right);\
+        return left;\
+    }\
+    uint64_t c_height, d_height;\
+    lagus_##T##_##E##_child_heights (buffer, b, b_height, & c_height, & d_height);\
+    uint64_t c = buffer [b].left_child;\
+    uint64_t d = buffer [b].right_child;\
+    uint64_t height_left = lagus_##T##_##E##_make (buffer, a, a_height, left, c, c_height);\
+    uint64_t height_right = lagus_##T##_##E##_make (buffer, d, d_height, node, right, right_height);\
+    * height = lagus_##T##_##E##_make (buffer, left, height_left, b, node, height_right);\
+    return b;\
+}\
+\
+static uint64_t lagus_##T##_##E##_join_nodes (lagus_##T##_node_##E * buffer, uint64_t left, uint64_t left_height, uint64_t node, uint64_t right, uint64_t right_height, uint64_t * height) {\
+    uint64_t a_height, b_height;\
+    if (left_height > right_height + 1) {\
+        lagus_##T##_##E##_child_heights (buffer, left, left_height, & a_height, & b_height);\
+        uint64_t b = lagus_##T##_##E##_join_nodes (buffer, buffer [left].right_child, b_height, node, right, right_height, & b_height);\
+        return lagus_##T##_##E##_balance_right (buffer, buffer [left].left_child, a_height, left, b, b_height, height);\
+    }\
+    if (right_height > left_height + 1) {\
+        lagus_##T##_##E##_child_heights (buffer, right, right_height, & a_height, & b_height);\
+        uint64_t a = lagus_##T##_##E##_join_nodes (buffer, left, left_height, node, buffer [right].left_child, a_height, & a_height);\
+        return lagus_##T##_##E##_balance_left (buffer, a, a_height, right, buffer [right].right_child, b_height, height);\
+    }\
+    * height = lagus_##T##_##E##_make (buffer, left, left_height, node, right, right_height);\
+    return node;\
+}\
+\
+static uint64_t lagus_##T##_##E##_split_first (lagus_##T##_node_##E * buffer, uint64_t node, uint64_t height, uint64_t * first, uint64_t * rest_height) {\
+    uint64_t left_height, right_height;\
+    lagus_##T##_##E##_child_heights (buffer, node, height, & left_height, & right_height);\
+    uint64_t left = buffer [node].left_child;\
+    if (! left) {\
+        * first = node;\
+        * rest_height = right_height;\
+        return buffer [node].right_child;\
+    }\
+    left = lagus_##T##_##E##_split_first (buffer, left, left_height, first, & left_height);\
+    return lagus_##T##_##E##_join_nodes (buffer, left, left_height, node, buffer [node].right_child, right_height, rest_height);\
+}\
+\
+static uint64_t lagus_##T##_##E##_join_pair (lagus_##T##_node_##E * buffer, uint64_t left, uint64_t left_height, uint64_t right, uint64_t right_height, uint64_t * height) {\
+    if (! left) {\
+        * height = right_height;\
+        return right;\
+    }\
+    if (! right) {\
+        * height = left_height;\
+        return left;\
+    }\
+    uint64_t node;\
+    right = lagus_##T##_##E##_split_first (buffer, right, right_height, & node, & right_height);\
+    return lagus_##T##_##E##_join_nodes (buffer, left, left_height, node, right, right_height, height);\
+}\
+\
+static void lagus_##T##_##E##_split_count (lagus_##T##_node_##E * buffer, uint64_t node, uint64_t height, uint64_t count, uint64_t * left, uint64_t * left_height, uint64_t * right, uint64_t * right_height) {\
+    if (! node) {\
+        * left = lagus_none;\
+        * left_height = 0;\
+        * right = lagus_none;\
+        * right_height = 0;\
+        return;\
+    }\
+    uint64_t a_height, b_height;\
+    lagus_##T##_##E##_child_heights (buffer, node, height, & a_height, & b_height);\
+    uint64_t a = buffer [node].left_child;\
+    uint64_t b = buffer [node].right_child;\
+    uint64_t a_size = 0;\
+    if (a)\
+        a_size = buffer [a].size;\
+    if (count <= a_size) {\
+        lagus_##T##_##E##_split_count (buffer, a, a_height, count, left, left_height, & a, & a_height);\
+        * right = lagus_##T##_##E##_join_nodes (buffer, a, a_height, node, b, b_height, right_height);\
+    } else {\
+        lagus_##T##_##E##_split_count (buffer, b, b_height, count - a_size - 1, & b, & b_height, right, right_height);\
+        * left = lagus_##T##_##E##_join_nodes (buffer, a, a_height, node, b, b_height, left_height);\
+    }\
+}\
+\
+static void lagus_##T##_##E##_swap_nodes (lagus_##T##_node_##E * buffer, uint64_t a, uint64_t b) {\
+    uint64_t nodes [2] = { a, b };\
+    for (uint64_t index = 0; index < 2; index ++) {\
+        uint64_t node = nodes [index];\
+        uint64_t parent = buffer [node].parent;\
+        if (parent && parent != a && parent != b && ! (index == 1 && parent == buffer [a].parent)) {\
+            if (buffer [parent].left_child == a)\
+                buffer [parent].left_child = b;\
+            else if (buffer [parent].left_child == b)\
+                buffer [parent].left_child = a;\
+            if (buffer [parent].right_child == a)\
+                buffer [parent].right_child = b;\
+            else if (buffer [parent].right_child == b)\
+                buffer [parent].right_child = a;\
+        }\
+        uint64_t child = buffer [node].left_child;\
+        if (child && child != a && child != b)\
+            buffer [child].parent = a + b - node;\
+        child = buffer [node].right_child;\
+        if (child && child != a && child != b)\
+            buffer [child].parent = a + b - node;\
+    }\
+    lagus_##T##_node_##E temporal = buffer [a];\
+    buffer [a] = buffer [b];\
+    buffer [b] = temporal;\
+    for (uint64_t index = 0; index < 2; index ++) {\
+        lagus_##T##_node_##E * node = buffer + nodes [index];\
+        if (node -> parent == a || node -> parent == b)\
+            node -> parent = a + b - node -> parent;\
+        if (node -> left_child == a || node -> left_child == b)\
+            node -> left_child = a + b - node -> left_child;\
+        if (node -> right_child == a || node -> right_child == b)\
+            node -> right_child = a + b - node -> right_child;\
+    }\
+}\
+\
+static uint64_t lagus_##T##_##E##_compact (lagus_##T##_node_##E * buffer, uint64_t root, uint64_t size, uint64_t kept) {\
+    uint64_t hole = lagus_root;\
+    uint64_t node = size;\
     while (true) {\
-        if (bytes_a [index] < bytes_b [index])\
-            return -1;\
-        if (bytes_a [index] > bytes_b [index])\
-            return 1;\
-        if (index == 0)\
-            return 0;\
-        index --;\
+        while (hole <= kept && buffer [hole].size)\
+            hole ++;\
+        while (node > kept && ! buffer [node].size)\
+            node --;\
+        if (hole > kept || node <= kept)\
+            break;\
+        buffer [hole] = buffer [node];\
+        uint64_t parent = buffer [hole].parent;\
+        if (parent) {\
+            if (buffer [parent].left_child == node)\
+                buffer [parent].left_child = hole;\
+            else\
+                buffer [parent].right_child = hole;\
+        } else\
+            root = hole;\
+        uint64_t child = buffer [hole].left_child;\
+        if (child)\
+            buffer [child].parent = hole;\
+        child = buffer [hole].right_child;\
+        if (child)\
+            buffer [child].parent = hole;\
+        buffer [node].size = 0;\
     }\
+    if (root != lagus_root)\
+        lagus_##T##_##E##_swap_nodes (buffer, lagus_root, root);\
+    return lagus_root;\
+}\
+\
+static void lagus_##T##_##E##_release (lagus_##T##_node_##E * buffer, uint64_t node) {\
+    while (node) {\
+        lagus_##T##_##E##_release (buffer, buffer [node].left_child);\
+        buffer [node].size = 0;\
+        node = buffer [node].right_child;\
+    }\
+}
+
+# define lagus_implement_bst_named(E, T, C, B, U) \
+\
+static inline int64_t lagus_##T##_##E##_compare (lagus_compare_##E compare, E a, E b) {\
+    return C (a, b);\
 }\
 \
-lagus_result lagus_bst_##E##_initialize (lagus_bst_##E * bst) {\
-    lagus_bst_node_##E * buffer = aligned_alloc (_Alignof (lagus_bst_node_##E), sizeof (lagus_bst_node_##E));\
+lagus_implement_bst_nodes(E, T, U, lagus_bst_no_update)\
+\
+lagus_result lagus_##T##_##E##_initialize (lagus_##T##_##E * bst) {\
+    lagus_##T##_node_##E * buffer = aligned_alloc (_Alignof (lagus_##T##_node_##E), sizeof (lagus_##T##_node_##E));\
     if (! buffer)\
         return lagus_memory_allocation;\
-    * bst = (lagus_bst_##E) {\
+    * bst = (lagus_##T##_##E) {\
         .height = 0,\
         .capacity = 1,\
+        .modifications = 0,\
         .buffer = buffer - 1,\
-        .compare = lagus_binary_compare_##E,\
+        .compare = B,\
         .memory_management.allocate = aligned_alloc,\
         .memory_management.reallocate = realloc,\
         .memory_management.deallocate = free\
     };\
-    * buffer = (lagus_bst_node_##E) {\
+    * buffer = (lagus_##T##_node_##E) {\
         .parent = lagus_none,\
         .left_child = lagus_none,\
         .right_child = lagus_none,\
@@ -1278,17 +1700,17 @@ lagus_result lagus_bst_##E##_initialize (lagus_bst_##E * bst) {\
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_custom_initialize (lagus_bst_##E * bst, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management) {\
-    lagus_bst_node_##E * buffer;\
+lagus_result lagus_##T##_##E##_custom_initialize (lagus_##T##_##E * bst, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management) {\
+    lagus_##T##_node_##E * buffer;\
     if (! capacity)\
         capacity = 1;\
     if (memory_management) {\
-        buffer = memory_management -> allocate (_Alignof (lagus_bst_node_##E), capacity * sizeof (lagus_bst_node_##E));\
+        buffer = memory_management -> allocate (_Alignof (lagus_##T##_node_##E), capacity * sizeof (lagus_##T##_node_##E));\
         if (! buffer)\
             return lagus_memory_allocation;\
         bst -> memory_management = * memory_management;\
     } else {\
-        buffer = aligned_alloc (_Alignof (lagus_bst_node_##E), capacity * sizeof (lagus_bst_node_##E));\
+        buffer = aligned_alloc (_Alignof (lagus_##T##_node_##E), capacity * sizeof (lagus_##T##_node_##E));\
         if (! buffer)\
             return lagus_memory_allocation;\
         bst -> memory_management = (lagus_memory_management) {\
@@ -1298,245 +1720,209 @@ lagus_result lagus_bst_##E##_custom_initialize (lagus_bst_##E * bst, uint64_t ca
         };\
     }\
     bst -> height = 0;\
-    bst -> capacity = 1;\
+    bst -> capacity = capacity;\
+    bst -> modifications = 0;\
     bst -> buffer = buffer - 1;\
     if (compare)\
         bst -> compare = compare;\
     else\
-        bst -> compare = lagus_binary_compare_##E;\
-    * buffer = (lagus_bst_node_##E) {\
+        bst -> compare = B;\
+    * buffer = (lagus_##T##_node_##E) {\
         .parent = lagus_none,\
         .left_child = lagus_none,\
         .right_child = lagus_none,\
         .size = 0\
     };\
+    return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_finalize (lagus_bst_##E * bst) {\
+lagus_result lagus_##T##_##E##_finalize (lagus_##T##_##E * bst) {\
     bst -> memory_management.deallocate (bst -> buffer + 1);\
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_size (lagus_bst_##E * bst, uint64_t * size) {\
+lagus_result lagus_##T##_##E##_size (lagus_##T##_##E * bst, uint64_t * size) {\
     * size = bst -> buffer [lagus_root].size;\
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_add_left (lagus_bst_##E * bst, E element) {\
-    if (bst -> height == 0) {\
-        bst -> buffer [lagus_root].size = 1;\
-        bst -> buffer [lagus_root].configuration = 0b00;\
-        bst -> buffer [lagus_root].element = element;\
-        bst -> height = 1;\
-    } else {\
-        uint64_t size = bst -> buffer [lagus_root].size;\
-        if (size == bst -> capacity) {\
-            uint64_t capacity = bst -> capacity << 1;\
-            lagus_bst_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_bst_node_##E));\
-            if (! buffer)\
-                return lagus_memory_allocation;\
-            bst -> capacity = capacity;\
-            bst -> buffer = buffer - 1;\
-        }\
-        \
-        size ++;\
-        bst -> buffer [size] = (lagus_bst_node_##E) {\
-            .left_child = lagus_none,\
-            .right_child = lagus_none,\
-            .size = 1,\
-            .configuration = 0b00,\
-            .element = element\
-        };\
-        uint8_t direction;\
-        uint64_t node = lagus_root;\
-        while (true) {\
-            uint64_t child;\
-            int64_t comparison = bst -> compare (element, bst -> buffer [node].element);\
-            if (comparison <= 0) {\
-                child = bst -> buffer [node].left_child;\
-                if (! child) {\
-                    bst -> buffer [node].left_child = size;\
-                    direction = lagus_left;\
-                    break;\
-                }\
-            }\
-            else {\
-                child = bst -> buffer [node].right_child;\
-                if (! child) {\
-                    bst -> buffer [node].right_child = size;\
-                    direction = lagus_right;\
-                    break;\
-                }\
+static void lagus_##T##_##E##_rebalance_add (lagus_##T##_##E * bst, uint64_t node, uint8_t direction) {\
+    uint64_t child;\
+    while (true) {\
+        bst -> buffer [node].size ++;\
+        if (bst -> buffer [node].configuration == 0b00) {\
+            if (direction == lagus_left)\
+                bst -> buffer [node].configuration = 0b10;\
+            else\
+                bst -> buffer [node].configuration = 0b01;\
+            U (bst -> buffer, node);\
+            if (node == lagus_root) {\
+                bst -> height ++;\
+                return;\
             }\
-            node = child;\
+            child = node;\
+            node = bst -> buffer [node].parent;\
+            if (bst -> buffer [node].left_child == child)\
+                direction = lagus_left;\
+            else\
+                direction = lagus_right;\
+            continue;\
         }\
-        bst -> buffer [size].parent = node;\
-        uint64_t child;\
-        while (true) {\
-            bst -> buffer [node].size ++;\
-            if (bst -> buffer [node].configuration == 0b00) {\
-                if (direction == lagus_left)\
-                    bst -> buffer [node].configuration = 0b10;\
-                else\
-                    bst -> buffer [node].configuration = 0b01;\
-                if (node == lagus_root) {\
-                    bst -> height ++;\
-                    return lagus_success;\
-                }\
-                child = node;\
-                node = bst -> buffer [node].parent;\
-                if (bst -> buffer [node].left_child == child)\
-                    direction = lagus_left;\
-                else\
-                    direction = lagus_right;\
-                continue;\
-            }\
-            if (bst -> buffer [node].configuration == 0b10) {\
-                if (direction == lagus_left) {\
-                    child = bst -> buffer [node].left_child;\
-                    if (bst -> buffer [child].configuration == 0b10) {\
-                        uint64_t b = child;\
-                        uint64_t a = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].size -= bst -> buffer [a].size;\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].left_child = X;\
-                        uint64_t W = bst -> buffer [node].right_child;\
-                        bst -> buffer [b].right_child = W;\
-                        if (W) {\
-                            bst -> buffer [W].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [W].size;\
-                        }\
-                        bst -> buffer [node].left_child = a;\
-                        bst -> buffer [a].parent = node;\
-                        bst -> buffer [node].right_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        bst -> buffer [child].configuration = 0b00;\
+        if (bst -> buffer [node].configuration == 0b10) {\
+            if (direction == lagus_left) {\
+                child = bst -> buffer [node].left_child;\
+                if (bst -> buffer [child].configuration == 0b10) {\
+                    uint64_t b = child;\
+                    uint64_t a = bst -> buffer [b].left_child;\
+                    bst -> buffer [b].size -= bst -> buffer [a].size;\
+                    uint64_t X = bst -> buffer [b].right_child;\
+                    bst -> buffer [b].left_child = X;\
+                    uint64_t W = bst -> buffer [node].right_child;\
+                    bst -> buffer [b].right_child = W;\
+                    if (W) {\
+                        bst -> buffer [W].parent = b;\
+                        bst -> buffer [b].size += bst -> buffer [W].size;\
+                    }\
+                    bst -> buffer [node].left_child = a;\
+                    bst -> buffer [a].parent = node;\
+                    bst -> buffer [node].right_child = b;\
+                    bst -> buffer [b].parent = node;\
+                    E temporal = bst -> buffer [node].element;\
+                    bst -> buffer [node].element = bst -> buffer [b].element;\
+                    bst -> buffer [b].element = temporal;\
+                    U (bst -> buffer, b);\
+                    bst -> buffer [child].configuration = 0b00;\
+                } else {\
+                    uint64_t a = child;\
+                    uint64_t b = bst -> buffer [a].right_child;\
+                    bst -> buffer [a].size -= bst -> buffer [b].size;\
+                    uint64_t Y = bst -> buffer [b].left_child;\
+                    bst -> buffer [a].right_child = Y;\
+                    if (Y) {\
+                        bst -> buffer [Y].parent = a;\
+                        bst -> buffer [a].size += bst -> buffer [Y].size;\
+                        bst -> buffer [b].size -= bst -> buffer [Y].size;\
+                    }\
+                    uint64_t X = bst -> buffer [b].right_child;\
+                    bst -> buffer [b].left_child = X;\
+                    uint64_t W = bst -> buffer [node].right_child;\
+                    bst -> buffer [b].right_child = W;\
+                    if (W) {\
+                        bst -> buffer [W].parent = b;\
+                        bst -> buffer [b].size += bst -> buffer [W].size;\
+                    }\
+                    bst -> buffer [node].right_child = b;\
+                    bst -> buffer [b].parent = node;\
+                    E temporal = bst -> buffer [node].element;\
+                    bst -> buffer [node].element = bst -> buffer [b].element;\
+                    bst -> buffer [b].element = temporal;\
+                    U (bst -> buffer, a);\
+                    U (bst -> buffer, b);\
+                    if (bst -> buffer [b].configuration == 0b00)\
+                        bst -> buffer [a].configuration = 0b00;\
+                    else if (bst -> buffer [b].configuration == 0b10) {\
+                        bst -> buffer [a].configuration = 0b00;\
+                        bst -> buffer [b].configuration = 0b01;\
                     } else {\
-                        uint64_t a = child;\
-                        uint64_t b = bst -> buffer [a].right_child;\
-                        bst -> buffer [a].size -= bst -> buffer [b].size;\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [a].right_child = Y;\
-                        if (Y) {\
-                            bst -> buffer [Y].parent = a;\
-                            bst -> buffer [a].size += bst -> buffer [Y].size;\
-                            bst -> buffer [b].size -= bst -> buffer [Y].size;\
-                        }\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].left_child = X;\
-                        uint64_t W = bst -> buffer [node].right_child;\
-                        bst -> buffer [b].right_child = W;\
-                        if (W) {\
-                            bst -> buffer [W].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [W].size;\
-                        }\
-                        bst -> buffer [node].right_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        if (bst -> buffer [b].configuration == 0b00)\
-                            bst -> buffer [a].configuration = 0b00;\
-                        else if (bst -> buffer [b].configuration == 0b10) {\
-                            bst -> buffer [a].configuration = 0b00;\
-                            bst -> buffer [b].configuration = 0b01;\
-                        } else {\
-                            bst -> buffer [a].configuration = 0b10;\
-                            bst -> buffer [b].configuration = 0b00;\
-                        }\
+                        bst -> buffer [a].configuration = 0b10;\
+                        bst -> buffer [b].configuration = 0b00;\
                     }\
                 }\
-            } else {\
-                if (direction == lagus_right) {\
-                    child = bst -> buffer [node].right_child;\
-                    if (bst -> buffer [child].configuration == 0b01) {\
-                        uint64_t b = child;\
-                        uint64_t c = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].size -= bst -> buffer [c].size;\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].right_child = Y;\
-                        uint64_t Z = bst -> buffer [node].left_child;\
-                        bst -> buffer [b].left_child = Z;\
-                        if (Z) {\
-                            bst -> buffer [Z].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [Z].size;\
-                        }\
-                        bst -> buffer [node].right_child = c;\
-                        bst -> buffer [c].parent = node;\
-                        bst -> buffer [node].left_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        bst -> buffer [child].configuration = 0b00;\
-                    } else {\
-                        uint64_t c = child;\
-                        uint64_t b = bst -> buffer [c].left_child;\
-                        bst -> buffer [c].size -= bst -> buffer [b].size;\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [c].left_child = X;\
-                        if (X) {\
-                            bst -> buffer [X].parent = c;\
-                            bst -> buffer [c].size += bst -> buffer [X].size;\
-                            bst -> buffer [b].size -= bst -> buffer [X].size;\
-                        }\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].right_child = Y;\
-                        uint64_t Z = bst -> buffer [node].left_child;\
-                        bst -> buffer [b].left_child = Z;\
-                        if (Z) {\
-                            bst -> buffer [Z].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [Z].size;\
-                        }\
-                        bst -> buffer [node].left_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        if (bst -> buffer [b].configuration == 0b00) {\
-                            bst -> buffer [c].configuration = 0b00;\
-                        } else if (bst -> buffer [b].configuration == 0b01) {\
-                            bst -> buffer [c].configuration = 0b00;\
-                            bst -> buffer [b].configuration = 0b10;\
-                        } else {\
-                            bst -> buffer [c].configuration = 0b01;\
-                            bst -> buffer [b].configuration = 0b00;\
-                        }\
+            }\
+        } else {\
+            if (direction == lagus_right) {\
+                child = bst -> buffer [node].right_child;\
+                if (bst -> buffer [child].configuration == 0b01) {\
+                    uint64_t b = child;\
+                    uint64_t c = bst -> buffer [b].right_child;\
+                    bst -> buffer [b].size -= bst -> buffer [c].size;\
+                    uint64_t Y = bst -> buffer [b].left_child;\
+                    bst -> buffer [b].right_child = Y;\
+                    uint64_t Z = bst -> buffer [node].left_child;\
+                    bst -> buffer [b].left_child = Z;\
+                    if (Z) {\
+                        bst -> buffer [Z].parent = b;\
+                        bst -> buffer [b].size += bst -> buffer [Z].size;\
+                    }\
+                    bst -> buffer [node].right_child = c;\
+                    bst -> buffer [c].parent = node;\
+                    bst -> buffer [node].left_child = b;\
+                    bst -> buffer [b].parent = node;\
+                    E temporal = bst -> buffer [node].element;\
+                    bst -> buffer [node].element = bst -> buffer [b].element;\
+                    bst -> buffer [b].element = temporal;\
+                    U (bst -> buffer, b);\
+                    bst -> buffer [child].configuration = 0b00;\
+                } else {\
+                    uint64_t c = child;\
+                    uint64_t b = bst -> buffer [c].left_child;\
+                    bst -> buffer [c].size -= bst -> buffer [b].size;\
+                    uint64_t X = bst -> buffer [b].right_child;\
+                    bst -> buffer [c].left_child = X;\
+                    if (X) {\
+                        bst -> buffer [X].parent = c;\
+                        bst -> buffer [c].size += bst -> buffer [X].size;\
+                        bst -> buffer [b].size -= bst -> buffer [X].size;\
+                    }\
+                    uint64_t Y = bst -> buffer [b].left_child;\
+                    bst -> buffer [b].right_child = Y;\
+                    uint64_t Z = bst -> buffer [node].left_child;\
+                    bst -> buffer [b].left_child = Z;\
+                    if (Z) {\
+                        bst -> buffer [Z].parent = b;\
+                        bst -> buffer [b].size += bst -> buffer [Z].size;\
+                    }\
+                    bst -> buffer [node].left_child = b;\
+                    bst -> buffer [b].parent = node;\
+                    E temporal = bst -> buffer [node].element;\
+                    bst -> buffer [node].element = bst -> buffer [b].element;\
+                    bst -> buffer [b].element = temporal;\
+                    U (bst -> buffer, c);\
+                    U (bst -> buffer, b);\
+                    if (bst -> buffer [b].configuration == 0b00) {\
+                        bst -> buffer [c].configuration = 0b00;\
+                    } else if (bst -> buffer [b].configuration == 0b01) {\
+                        bst -> buffer [c].configuration = 0b00;\
+                        bst -> buffer [b].configuration = 0b10;\
+                    } else {\
+                        bst -> buffer [c].configuration = 0b01;\
+                        bst -> buffer [b].configuration = 0b00;\
                     }\
                 }\
             }\
-            bst -> buffer [node].configuration = 0b00;\
-            break;\
-        }\
-        while (node != lagus_root) {\
-            node = bst -> buffer [node].parent;\
-            bst -> buffer [node].size ++;\
         }\
+        bst -> buffer [node].configuration = 0b00;\
+        break;\
+    }\
+    U (bst -> buffer, node);\
+    while (node != lagus_root) {\
+        node = bst -> buffer [node].parent;\
+        bst -> buffer [node].size ++;\
+        U (bst -> buffer, node);\
     }\
-    return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_add_right (lagus_bst_##E * bst, E element) {\
+lagus_result lagus_##T##_##E##_add_left (lagus_##T##_##E * bst, E element) {\
+    bst -> modifications ++;\
     if (bst -> height == 0) {\
         bst -> buffer [lagus_root].size = 1;\
         bst -> buffer [lagus_root].configuration = 0b00;\
         bst -> buffer [lagus_root].element = element;\
+        U (bst -> buffer, lagus_root);\
         bst -> height = 1;\
     } else {\
         uint64_t size = bst -> buffer [lagus_root].size;\
         if (size == bst -> capacity) {\
             uint64_t capacity = bst -> capacity << 1;\
-            lagus_bst_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_bst_node_##E));\
+            lagus_##T##_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_##T##_node_##E));\
             if (! buffer)\
                 return lagus_memory_allocation;\
             bst -> capacity = capacity;\
             bst -> buffer = buffer - 1;\
         }\
+        \
         size ++;\
-        bst -> buffer [size] = (lagus_bst_node_##E) {\
+        bst -> buffer [size] = (lagus_##T##_node_##E) {\
             .left_child = lagus_none,\
             .right_child = lagus_none,\
             .size = 1,\
@@ -1547,8 +1933,8 @@ lagus_result lagus_bst_##E##_add_right (lagus_bst_##E * bst, E element) {\
         uint64_t node = lagus_root;\
         while (true) {\
             uint64_t child;\
-            int64_t comparison = bst -> compare (element, bst -> buffer [node].element);\
-            if (comparison < 0) {\
+            int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, element, bst -> buffer [node].element);\
+            if (comparison <= 0) {\
                 child = bst -> buffer [node].left_child;\
                 if (! child) {\
                     bst -> buffer [node].left_child = size;\
@@ -1567,166 +1953,200 @@ lagus_result lagus_bst_##E##_add_right (lagus_bst_##E * bst, E element) {\
             node = child;\
         }\
         bst -> buffer [size].parent = node;\
-        \
-        uint64_t child;\
+        U (bst -> buffer, size);\
+        lagus_##T##_##E##_rebalance_add (bst, node, direction);\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_add_right (lagus_##T##_##E * bst, E element) {\
+    bst -> modifications ++;\
+    if (bst -> height == 0) {\
+        bst -> buffer [lagus_root].size = 1;\
+        bst -> buffer [lagus_root].configuration = 0b00;\
+        bst -> buffer [lagus_root].element = element;\
+        U (bst -> buffer, lagus_root);\
+        bst -> height = 1;\
+    } else {\
+        uint64_t size = bst -> buffer [lagus_root].size;\
+        if (size == bst -> capacity) {\
+            uint64_t capacity = bst -> capacity << 1;\
+            lagus_##T##_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_##T##_node_##E));\
+            if (! buffer)\
+                return lagus_memory_allocation;\
+            bst -> capacity = capacity;\
+            bst -> buffer = buffer - 1;\
+        }\
+        size ++;\
+        bst -> buffer [size] = (lagus_##T##_node_##E) {\
+            .left_child = lagus_none,\
+            .right_child = lagus_none,\
+            .size = 1,\
+            .configuration = 0b00,\
+            .element = element\
+        };\
+        uint8_t direction;\
+        uint64_t node = lagus_root;\
         while (true) {\
-            bst -> buffer [node].size ++;\
-            if (bst -> buffer [node].configuration == 0b00) {\
-                if (direction == lagus_left)\
-                    bst -> buffer [node].configuration = 0b10;\
-                else\
-                    bst -> buffer [node].configuration = 0b01;\
-                if (node == lagus_root) {\
-                    bst -> height ++;\
-                    return lagus_success;\
-                }\
-                child = node;\
-                node = bst -> buffer [node].parent;\
-                if (bst -> buffer [node].left_child == child)\
+            uint64_t child;\
+            int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, element, bst -> buffer [node].element);\
+            if (comparison < 0) {\
+                child = bst -> buffer [node].left_child;\
+                if (! child) {\
+                    bst -> buffer [node].left_child = size;\
                     direction = lagus_left;\
-                else\
-                    direction = lagus_right;\
-                continue;\
-            }\
-            if (bst -> buffer [node].configuration == 0b10) {\
-                if (direction == lagus_left) {\
-                    child = bst -> buffer [node].left_child;\
-                    if (bst -> buffer [child].configuration == 0b10) {\
-                        uint64_t b = child;\
-                        uint64_t a = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].size -= bst -> buffer [a].size;\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].left_child = X;\
-                        uint64_t W = bst -> buffer [node].right_child;\
-                        bst -> buffer [b].right_child = W;\
-                        if (W) {\
-                            bst -> buffer [W].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [W].size;\
-                        }\
-                        bst -> buffer [node].left_child = a;\
-                        bst -> buffer [a].parent = node;\
-                        bst -> buffer [node].right_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        bst -> buffer [child].configuration = 0b00;\
-                    } else {\
-                        uint64_t a = child;\
-                        uint64_t b = bst -> buffer [a].right_child;\
-                        bst -> buffer [a].size -= bst -> buffer [b].size;\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [a].right_child = Y;\
-                        if (Y) {\
-                            bst -> buffer [Y].parent = a;\
-                            bst -> buffer [a].size += bst -> buffer [Y].size;\
-                            bst -> buffer [b].size -= bst -> buffer [Y].size;\
-                        }\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].left_child = X;\
-                        uint64_t W = bst -> buffer [node].right_child;\
-                        bst -> buffer [b].right_child = W;\
-                        if (W) {\
-                            bst -> buffer [W].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [W].size;\
-                        }\
-                        bst -> buffer [node].right_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        if (bst -> buffer [b].configuration == 0b00)\
-                            bst -> buffer [a].configuration = 0b00;\
-                        else if (bst -> buffer [b].configuration == 0b10) {\
-                            bst -> buffer [a].configuration = 0b00;\
-                            bst -> buffer [b].configuration = 0b01;\
-                        } else {\
-                            bst -> buffer [a].configuration = 0b10;\
-                            bst -> buffer [b].configuration = 0b00;\
-                        }\
-                    }\
+                    break;\
                 }\
-            } else {\
-                if (direction == lagus_right) {\
-                    child = bst -> buffer [node].right_child;\
-                    if (bst -> buffer [child].configuration == 0b01) {\
-                        uint64_t b = child;\
-                        uint64_t c = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].size -= bst -> buffer [c].size;\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].right_child = Y;\
-                        uint64_t Z = bst -> buffer [node].left_child;\
-                        bst -> buffer [b].left_child = Z;\
-                        if (Z) {\
-                            bst -> buffer [Z].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [Z].size;\
-                        }\
-                        bst -> buffer [node].right_child = c;\
-                        bst -> buffer [c].parent = node;\
-                        bst -> buffer [node].left_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        bst -> buffer [child].configuration = 0b00;\
-                    } else {\
-                        uint64_t c = child;\
-                        uint64_t b = bst -> buffer [c].left_child;\
-                        bst -> buffer [c].size -= bst -> buffer [b].size;\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [c].left_child = X;\
-                        if (X) {\
-                            bst -> buffer [X].parent = c;\
-                            bst -> buffer [c].size += bst -> buffer [X].size;\
-                            bst -> buffer [b].size -= bst -> buffer [X].size;\
-                        }\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].right_child = Y;\
-                        uint64_t Z = bst -> buffer [node].left_child;\
-                        bst -> buffer [b].left_child = Z;\
-                        if (Z) {\
-                            bst -> buffer [Z].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [Z].size;\
-                        }\
-                        bst -> buffer [node].left_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        if (bst -> buffer [b].configuration == 0b00) {\
-                            bst -> buffer [c].configuration = 0b00;\
-                        } else if (bst -> buffer [b].configuration == 0b01) {\
-                            bst -> buffer [c].configuration = 0b00;\
-                            bst -> buffer [b].configuration = 0b10;\
-                        } else {\
-                            bst -> buffer [c].configuration = 0b01;\
-                            bst -> buffer [b].configuration = 0b00;\
-                        }\
-                    }\
+            }\
+            else {\
+                child = bst -> buffer [node].right_child;\
+                if (! child) {\
+                    bst -> buffer [node].right_child = size;\
+                    direction = lagus_right;\
+                    break;\
                 }\
             }\
-            bst -> buffer [node].configuration = 0b00;\
+            node = child;\
+        }\
+        bst -> buffer [size].parent = node;\
+        U (bst -> buffer, size);\
+        lagus_##T##_##E##_rebalance_add (bst, node, direction);\
+    }\
+    return lagus_success;\
+}\
+\
+static lagus_result lagus_##T##_##E##_add_hint (lagus_##T##_##E * bst, uint64_t index, E element, uint8_t side, uint64_t * rank) {\
+    bst -> modifications ++;\
+    if (bst -> height == 0) {\
+        if (rank)\
+            * rank = 1;\
+        if (side == lagus_left)\
+            return lagus_##T##_##E##_add_left (bst, element);\
+        return lagus_##T##_##E##_add_right (bst, element);\
+    }\
+    uint64_t size = bst -> buffer [lagus_root].size;\
+    if (size == bst -> capacity) {\
+        uint64_t capacity = bst -> capacity << 1;\
+        lagus_##T##_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_##T##_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        bst -> capacity = capacity;\
+        bst -> buffer = buffer - 1;\
+    }\
+    if (index == 0)\
+        index = 1;\
+    else if (index > size)\
+        index = size;\
+    uint64_t node = lagus_root;\
+    while (true) {\
+        uint64_t left_child = bst -> buffer [node].left_child;\
+        uint64_t left_size;\
+        if (left_child)\
+            left_size = bst -> buffer [left_child].size;\
+        else\
+            left_size = 0;\
+        if (index == left_size + 1)\
             break;\
+        if (index <= left_size)\
+            node = left_child;\
+        else {\
+            index -= left_size + 1;\
+            node = bst -> buffer [node].right_child;\
         }\
-        while (node != lagus_root) {\
-            node = bst -> buffer [node].parent;\
-            bst -> buffer [node].size ++;\
+    }\
+    int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, element, bst -> buffer [node].element);\
+    uint8_t direction;\
+    if (comparison < 0 || side == lagus_left && comparison == 0)\
+        direction = lagus_left;\
+    else\
+        direction = lagus_right;\
+    while (true) {\
+        uint64_t ancestor = node;\
+        uint64_t parent = bst -> buffer [ancestor].parent;\
+        while (ancestor != lagus_root) {\
+            if (direction == lagus_left && bst -> buffer [parent].right_child == ancestor)\
+                break;\
+            if (direction == lagus_right && bst -> buffer [parent].left_child == ancestor)\
+                break;\
+            ancestor = parent;\
+            parent = bst -> buffer [ancestor].parent;\
+        }\
+        if (ancestor == lagus_root)\
+            break;\
+        comparison = lagus_##T##_##E##_compare (bst -> compare, element, bst -> buffer [parent].element);\
+        bool before = comparison < 0 || side == lagus_left && comparison == 0;\
+        if (direction == lagus_left && ! before)\
+            break;\
+        if (direction == lagus_right && before)\
+            break;\
+        node = parent;\
+    }\
+    size ++;\
+    bst -> buffer [size] = (lagus_##T##_node_##E) {\
+        .left_child = lagus_none,\
+        .right_child = lagus_none,\
+        .size = 1,\
+        .configuration = 0b00,\
+        .element = element\
+    };\
+    while (true) {\
+        uint64_t child;\
+        if (direction == lagus_left) {\
+            child = bst -> buffer [node].left_child;\
+            if (! child) {\
+                bst -> buffer [node].left_child = size;\
+                break;\
+            }\
+        } else {\
+            child = bst -> buffer [node].right_child;\
+            if (! child) {\
+                bst -> buffer [node].right_child = size;\
+                break;\
+            }\
+        }\
+        node = child;\
+        comparison = lagus_##T##_##E##_compare (bst -> compare, element, bst -> buffer [node].element);\
+        if (comparison < 0 || side == lagus_left && comparison == 0)\
+            direction = lagus_left;\
+        else\
+            direction = lagus_right;\
+    }\
+    bst -> buffer [size].parent = node;\
+    U (bst -> buffer, size);\
+    if (rank) {\
+        * rank = 1;\
+        uint64_t child = size;\
+        while (child != lagus_root) {\
+            uint64_t parent = bst -> buffer [child].parent;\
+            if (bst -> buffer [parent].right_child == child) {\
+                * rank += 1;\
+                if (bst -> buffer [parent].left_child)\
+                    * rank += bst -> buffer [bst -> buffer [parent].left_child].size;\
+            }\
+            child = parent;\
         }\
     }\
+    lagus_##T##_##E##_rebalance_add (bst, node, direction);\
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_add_at (lagus_bst_##E * bst, uint64_t index, E element) {\
+lagus_result lagus_##T##_##E##_add_right_hint (lagus_##T##_##E * bst, uint64_t index, E element) {\
+    return lagus_##T##_##E##_add_hint (bst, index, element, lagus_right, NULL);\
+}\
+\
+lagus_result lagus_##T##_##E##_add_at (lagus_##T##_##E * bst, uint64_t index, E element) {\
+    bst -> modifications ++;\
     if (bst -> height == 0) {\
         bst -> buffer [lagus_root].size = 1;\
         bst -> buffer [lagus_root].configuration = 0b00;\
         bst -> buffer [lagus_root].element = element;\
+        U (bst -> buffer, lagus_root);\
         bst -> height = 1;\
     } else {\
         uint64_t size = bst -> buffer [lagus_root].size;\
         if (size == bst -> capacity) {\
             uint64_t capacity = bst -> capacity << 1;\
-            lagus_bst_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_bst_node_##E));\
+            lagus_##T##_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_##T##_node_##E));\
             if (! buffer)\
                 return lagus_memory_allocation;\
             bst -> capacity = capacity;\
@@ -1734,7 +2154,7 @@ lagus_result lagus_bst_##E##_add_at (lagus_bst_##E * bst, uint64_t index, E elem
         }\
         \
         size ++;\
-        bst -> buffer [size] = (lagus_bst_node_##E) {\
+        bst -> buffer [size] = (lagus_##T##_node_##E) {\
             .left_child = lagus_none,\
             .right_child = lagus_none,\
             .size = 1,\
@@ -1797,164 +2217,401 @@ lagus_result lagus_bst_##E##_add_at (lagus_bst_##E * bst, uint64_t index, E elem
             }\
         }\
         bst -> buffer [size].parent = node;\
-        \
-        uint64_t child;\
-        while (true) {\
-            bst -> buffer [node].size ++;\
-            if (bst -> buffer [node].configuration == 0b00) {\
-                if (direction == lagus_left)\
-                    bst -> buffer [node].configuration = 0b10;\
-                else\
-                    bst -> buffer [node].configuration = 0b01;\
-                if (node == lagus_root) {\
-                    bst -> height ++;\
-                    return lagus_success;\
-                }\
-                child = node;\
-                node = bst -> buffer [node].parent;\
-                if (bst -> buffer [node].left_child == child)\
-                    direction = lagus_left;\
-                else\
-                    direction = lagus_right;\
-                continue;\
-            }\
-            if (bst -> buffer [node].configuration == 0b10) {\
-                if (direction == lagus_left) {\
-                    child = bst -> buffer [node].left_child;\
-                    if (bst -> buffer [child].configuration == 0b10) {\
-                        uint64_t b = child;\
-                        uint64_t a = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].size -= bst -> buffer [a].size;\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].left_child = X;\
-                        uint64_t W = bst -> buffer [node].right_child;\
-                        bst -> buffer [b].right_child = W;\
-                        if (W) {\
-                            bst -> buffer [W].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [W].size;\
-                        }\
-                        bst -> buffer [node].left_child = a;\
-                        bst -> buffer [a].parent = node;\
-                        bst -> buffer [node].right_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        bst -> buffer [child].configuration = 0b00;\
-                    } else {\
-                        uint64_t a = child;\
-                        uint64_t b = bst -> buffer [a].right_child;\
-                        bst -> buffer [a].size -= bst -> buffer [b].size;\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [a].right_child = Y;\
-                        if (Y) {\
-                            bst -> buffer [Y].parent = a;\
-                            bst -> buffer [a].size += bst -> buffer [Y].size;\
-                            bst -> buffer [b].size -= bst -> buffer [Y].size;\
-                        }\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].left_child = X;\
-                        uint64_t W = bst -> buffer [node].right_child;\
-                        bst -> buffer [b].right_child = W;\
-                        if (W) {\
-                            bst -> buffer [W].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [W].size;\
-                        }\
-                        bst -> buffer [node].right_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        if (bst -> buffer [b].configuration == 0b00)\
-                            bst -> buffer [a].configuration = 0b00;\
-                        else if (bst -> buffer [b].configuration == 0b10) {\
-                            bst -> buffer [a].configuration = 0b00;\
-                            bst -> buffer [b].configuration = 0b01;\
-                        } else {\
-                            bst -> buffer [a].configuration = 0b10;\
-                            bst -> buffer [b].configuration = 0b00;\
-                        }\
-                    }\
-                }\
-            } else {\
-                if (direction == lagus_right) {\
-                    child = bst -> buffer [node].right_child;\
-                    if (bst -> buffer [child].configuration == 0b01) {\
-                        uint64_t b = child;\
-                        uint64_t c = bst -> buffer [b].right_child;\
-                        bst -> buffer [b].size -= bst -> buffer [c].size;\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].right_child = Y;\
-                        uint64_t Z = bst -> buffer [node].left_child;\
-                        bst -> buffer [b].left_child = Z;\
-                        if (Z) {\
-                            bst -> buffer [Z].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [Z].size;\
-                        }\
-                        bst -> buffer [node].right_child = c;\
-                        bst -> buffer [c].parent = node;\
-                        bst -> buffer [node].left_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        bst -> buffer [child].configuration = 0b00;\
-                    } else {\
-                        uint64_t c = child;\
-                        uint64_t b = bst -> buffer [c].left_child;\
-                        bst -> buffer [c].size -= bst -> buffer [b].size;\
-                        uint64_t X = bst -> buffer [b].right_child;\
-                        bst -> buffer [c].left_child = X;\
-                        if (X) {\
-                            bst -> buffer [X].parent = c;\
-                            bst -> buffer [c].size += bst -> buffer [X].size;\
-                            bst -> buffer [b].size -= bst -> buffer [X].size;\
-                        }\
-                        uint64_t Y = bst -> buffer [b].left_child;\
-                        bst -> buffer [b].right_child = Y;\
-                        uint64_t Z = bst -> buffer [node].left_child;\
-                        bst -> buffer [b].left_child = Z;\
-                        if (Z) {\
-                            bst -> buffer [Z].parent = b;\
-                            bst -> buffer [b].size += bst -> buffer [Z].size;\
-                        }\
-                        bst -> buffer [node].left_child = b;\
-                        bst -> buffer [b].parent = node;\
-                        E temporal = bst -> buffer [node].element;\
-                        bst -> buffer [node].element = bst -> buffer [b].element;\
-                        bst -> buffer [b].element = temporal;\
-                        if (bst -> buffer [b].configuration == 0b00) {\
-                            bst -> buffer [c].configuration = 0b00;\
-                        } else if (bst -> buffer [b].configuration == 0b01) {\
-                            bst -> buffer [c].configuration = 0b00;\
-                            bst -> buffer [b].configuration = 0b10;\
-                        } else {\
-                            bst -> buffer [c].configuration = 0b01;\
-                            bst -> buffer [b].configuration = 0b00;\
-                        }\
-                    }\
-                }\
+        U (bst -> buffer, size);\
+        lagus_##T##_##E##_rebalance_add (bst, node, direction);\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_build_sorted (lagus_##T##_##E * bst, E * elements, uint64_t size) {\
+    bst -> modifications ++;\
+    if (size > bst -> capacity) {\
+        lagus_##T##_node_##E * buffer = bst -> memory_management.allocate (_Alignof (lagus_##T##_node_##E), size * sizeof (lagus_##T##_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        bst -> memory_management.deallocate (bst -> buffer + 1);\
+        bst -> capacity = size;\
+        bst -> buffer = buffer - 1;\
+    }\
+    if (size == 0) {\
+        bst -> height = 0;\
+        bst -> buffer [lagus_root] = (lagus_##T##_node_##E) {\
+            .parent = lagus_none,\
+            .left_child = lagus_none,\
+            .right_child = lagus_none,\
+            .size = 0\
+        };\
+        return lagus_success;\
+    }\
+    lagus_##T##_##E##_build_subtree (bst -> buffer, elements, size, lagus_root, lagus_none);\
+    bst -> height = lagus_##T##_##E##_balanced_height (size);\
+    return lagus_success;\
+}\
+\
+static void lagus_##T##_##E##_merge (lagus_##T##_##E * bst, E * first, uint64_t first_size, E * second, uint64_t second_size, E * output) {\
+    while (first_size && second_size) {\
+        if (lagus_##T##_##E##_compare (bst -> compare, * first, * second) <= 0) {\
+            * output = * first;\
+            first ++;\
+            first_size --;\
+        } else {\
+            * output = * second;\
+            second ++;\
+            second_size --;\
+        }\
+        output ++;\
+    }\
+    while (first_size) {\
+        * output = * first;\
+        first ++;\
+        output ++;\
+        first_size --;\
+    }\
+    while (second_size) {\
+        * output = * second;\
+        second ++;\
+        output ++;\
+        second_size --;\
+    }\
+}\
+\
+static void lagus_##T##_##E##_sort (lagus_##T##_##E * bst, E * elements, E * scratch, uint64_t size) {\
+    for (uint64_t start = 0; start < size; start += 16) {\
+        uint64_t end = start + 16;\
+        if (end > size)\
+            end = size;\
+        for (uint64_t a = start + 1; a < end; a ++) {\
+            E element = elements [a];\
+            uint64_t b = a;\
+            while (b > start && lagus_##T##_##E##_compare (bst -> compare, element, elements [b - 1]) < 0) {\
+                elements [b] = elements [b - 1];\
+                b --;\
             }\
-            bst -> buffer [node].configuration = 0b00;\
-            break;\
+            elements [b] = element;\
         }\
-        while (node != lagus_root) {\
-            node = bst -> buffer [node].parent;\
-            bst -> buffer [node].size ++;\
+    }\
+    E * source = elements;\
+    E * destination = scratch;\
+    for (uint64_t width = 16; width < size; width <<= 1) {\
+        for (uint64_t start = 0; start < size; start += width << 1) {\
+            uint64_t middle = start + width;\
+            uint64_t end = middle + width;\
+            if (middle > size)\
+                middle = size;\
+            if (end > size)\
+                end = size;\
+            lagus_##T##_##E##_merge (bst, source + start, middle - start, source + middle, end - middle, destination + start);\
         }\
+        E * temporal = source;\
+        source = destination;\
+        destination = temporal;\
     }\
-    return lagus_success;\
+    if (source != elements)\
+        for (uint64_t index = 0; index < size; index ++)\
+            elements [index] = source [index];\
 }\
 \
-lagus_result lagus_bst_##E##_search_left (lagus_bst_##E * bst, E * element, uint64_t * index) {\
-    if (bst -> height == 0)\
+typedef struct lagus_##T##_task_##E {\
+    lagus_##T##_##E * bst;\
+    lagus_##T##_node_##E * buffer;\
+    E * elements;\
+    E * scratch;\
+    uint64_t size;\
+    uint64_t second_size;\
+    uint64_t start;\
+    uint64_t end;\
+    uint64_t node;\
+    uint64_t parent;\
+    bool started;\
+} lagus_##T##_task_##E;\
+\
+static void lagus_##T##_##E##_run_tasks (void * (* work) (void *), lagus_##T##_task_##E * tasks, pthread_t * threads, uint64_t count) {\
+    if (count == 0)\
+        return;\
+    for (uint64_t index = 1; index < count; index ++)\
+        tasks [index].started = pthread_create (threads + index, NULL, work, tasks + index) == 0;\
+    work (tasks);\
+    for (uint64_t index = 1; index < count; index ++)\
+        if (tasks [index].started)\
+            pthread_join (threads [index], NULL);\
+        else\
+            work (tasks + index);\
+}\
+\
+static void * lagus_##T##_##E##_sort_task (void * argument) {\
+    lagus_##T##_task_##E * task = argument;\
+    lagus_##T##_##E##_sort (task -> bst, task -> elements, task -> scratch, task -> size);\
+    return NULL;\
+}\
+\
+static uint64_t lagus_##T##_##E##_co_rank (lagus_##T##_##E * bst, E * first, uint64_t first_size, E * second, uint64_t second_size, uint64_t rank) {\
+    uint64_t lower = 0;\
+    uint64_t upper = rank;\
+    if (rank > second_size)\
+        lower = rank - second_size;\
+    if (upper > first_size)\
+        upper = first_size;\
+    while (true) {\
+        uint64_t a = lower + upper >> 1;\
+        uint64_t b = rank - a;\
+        if (a < first_size && b > 0 && lagus_##T##_##E##_compare (bst -> compare, second [b - 1], first [a]) >= 0)\
+            lower = a + 1;\
+        else if (a > 0 && b < second_size && lagus_##T##_##E##_compare (bst -> compare, first [a - 1], second [b]) > 0)\
+            upper = a - 1;\
+        else\
+            return a;\
+    }\
+}\
+\
+static void * lagus_##T##_##E##_merge_task (void * argument) {\
+    lagus_##T##_task_##E * task = argument;\
+    E * second = task -> elements + task -> size;\
+    uint64_t a = lagus_##T##_##E##_co_rank (task -> bst, task -> elements, task -> size, second, task -> second_size, task -> start);\
+    uint64_t b = lagus_##T##_##E##_co_rank (task -> bst, task -> elements, task -> size, second, task -> second_size, task -> end);\
+    uint64_t c = task -> start - a;\
+    uint64_t d = task -> end - b;\
+    lagus_##T##_##E##_merge (task -> bst, task -> elements + a, b - a, second + c, d - c, task -> scratch + task -> start);\
+    return NULL;\
+}\
+\
+static void * lagus_##T##_##E##_build_task (void * argument) {\
+    lagus_##T##_task_##E * task = argument;\
+    lagus_##T##_##E##_build_subtree (task -> buffer, task -> elements, task -> size, task -> node, task -> parent);\
+    return NULL;\
+}\
+\
+static void lagus_##T##_##E##_build_top (lagus_##T##_node_##E * buffer, E * elements, uint64_t size, uint64_t node, uint64_t parent, uint64_t depth, lagus_##T##_task_##E * tasks, uint64_t * count) {\
+    if (depth == 0) {\
+        tasks [* count] = (lagus_##T##_task_##E) {\
+            .buffer = buffer,\
+            .elements = elements,\
+            .size = size,\
+            .node = node,\
+            .parent = parent\
+        };\
+        (* count) ++;\
+        return;\
+    }\
+    uint64_t left_size = size - 1 >> 1;\
+    uint64_t right_size = size - 1 - left_size;\
+    buffer [node] = (lagus_##T##_node_##E) {\
+        .parent = parent,\
+        .left_child = lagus_none,\
+        .right_child = lagus_none,\
+        .size = size,\
+        .configuration = 0b00,\
+        .element = elements [left_size]\
+    };\
+    if (right_size != left_size && ! (right_size & right_size - 1))\
+        buffer [node].configuration = 0b01;\
+    if (left_size) {\
+        buffer [node].left_child = node + 1;\
+        lagus_##T##_##E##_build_top (buffer, elements, left_size, node + 1, node, depth - 1, tasks, count);\
+    }\
+    if (right_size) {\
+        buffer [node].right_child = node + left_size + 1;\
+        lagus_##T##_##E##_build_top (buffer, elements + left_size + 1, right_size, node + left_size + 1, node, depth - 1, tasks, count);\
+    }\
+}\
+\
+static void lagus_##T##_##E##_update_top (lagus_##T##_node_##E * buffer, uint64_t node, uint64_t depth) {\
+    if (depth == 0)\
+        return;\
+    uint64_t child = buffer [node].left_child;\
+    if (child)\
+        lagus_##T##_##E##_update_top (buffer, child, depth - 1);\
+    child = buffer [node].right_child;\
+    if (child)\
+        lagus_##T##_##E##_update_top (buffer, child, depth - 1);\
+    U (buffer, node);\
+}\
+\
+lagus_result lagus_##T##_##E##_build_parallel (lagus_##T##_##E * bst, E * elements, uint64_t size, uint64_t threads) {\
+    bst -> modifications ++;\
+    if (threads > size)\
+        threads = size;\
+    if (size == 0) {\
+        bst -> height = 0;\
+        bst -> buffer [lagus_root] = (lagus_##T##_node_##E) {\
+            .parent = lagus_none,\
+            .left_child = lagus_none,\
+            .right_child = lagus_none,\
+            .size = 0\
+        };\
+        return lagus_success;\
+    }\
+    lagus_##T##_node_##E * buffer = NULL;\
+    if (size > bst -> capacity) {\
+        buffer = bst -> memory_management.allocate (_Alignof (lagus_##T##_node_##E), size * sizeof (lagus_##T##_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+    }\
+    E * scratch = bst -> memory_management.allocate (_Alignof (E), size * sizeof (E));\
+    lagus_##T##_task_##E * tasks = NULL;\
+    pthread_t * handles = NULL;\
+    uint64_t depth = 0;\
+    uint64_t count = 0;\
+    if (threads > 1) {\
+        while (lagus_one << depth < threads)\
+            depth ++;\
+        count = lagus_one << depth;\
+        if (count < threads << 1)\
+            count = threads << 1;\
+        tasks = bst -> memory_management.allocate (_Alignof (lagus_##T##_task_##E), count * sizeof (lagus_##T##_task_##E));\
+        handles = bst -> memory_management.allocate (_Alignof (pthread_t), count * (sizeof (pthread_t) + sizeof (uint64_t)));\
+    }\
+    if (! scratch || threads > 1 && (! tasks || ! handles)) {\
+        if (buffer)\
+            bst -> memory_management.deallocate (buffer);\
+        if (scratch)\
+            bst -> memory_management.deallocate (scratch);\
+        if (tasks)\
+            bst -> memory_management.deallocate (tasks);\
+        if (handles)\
+            bst -> memory_management.deallocate (handles);\
+        return lagus_memory_allocation;\
+    }\
+    if (buffer) {\
+        bst -> memory_management.deallocate (bst -> buffer + 1);\
+        bst -> capacity = size;\
+        bst -> buffer = buffer - 1;\
+    }\
+    if (threads <= 1) {\
+        lagus_##T##_##E##_sort (bst, elements, scratch, size);\
+        bst -> memory_management.deallocate (scratch);\
+        lagus_##T##_##E##_build_subtree (bst -> buffer, elements, size, lagus_root, lagus_none);\
+        bst -> height = lagus_##T##_##E##_balanced_height (size);\
+        return lagus_success;\
+    }\
+    uint64_t * bounds = (uint64_t *) (handles + count);\
+    for (uint64_t index = 0; index <= threads; index ++)\
+        bounds [index] = size * index / threads;\
+    for (uint64_t index = 0; index < threads; index ++)\
+        tasks [index] = (lagus_##T##_task_##E) {\
+            .bst = bst,\
+            .elements = elements + bounds [index],\
+            .scratch = scratch + bounds [index],\
+            .size = bounds [index + 1] - bounds [index]\
+        };\
+    lagus_##T##_##E##_run_tasks (lagus_##T##_##E##_sort_task, tasks, handles, threads);\
+    E * source = elements;\
+    E * destination = scratch;\
+    uint64_t runs = threads;\
+    while (runs > 1) {\
+        uint64_t pairs = runs + 1 >> 1;\
+        uint64_t pieces = threads / pairs;\
+        if (! pieces)\
+            pieces = 1;\
+        uint64_t tasks_size = 0;\
+        for (uint64_t pair = 0; pair < pairs; pair ++) {\
+            uint64_t a = bounds [pair << 1];\
+            uint64_t b = bounds [(pair << 1) + 1];\
+            uint64_t c = b;\
+            if ((pair << 1) + 1 < runs)\
+                c = bounds [(pair << 1) + 2];\
+            for (uint64_t piece = 0; piece < pieces; piece ++) {\
+                tasks [tasks_size] = (lagus_##T##_task_##E) {\
+                    .bst = bst,\
+                    .elements = source + a,\
+                    .scratch = destination + a,\
+                    .size = b - a,\
+                    .second_size = c - b,\
+                    .start = (c - a) * piece / pieces,\
+                    .end = (c - a) * (piece + 1) / pieces\
+                };\
+                tasks_size ++;\
+            }\
+        }\
+        lagus_##T##_##E##_run_tasks (lagus_##T##_##E##_merge_task, tasks, handles, tasks_size);\
+        for (uint64_t pair = 0; pair < pairs; pair ++)\
+            bounds [pair] = bounds [pair << 1];\
+        bounds [pairs] = size;\
+        runs = pairs;\
+        E * temporal = source;\
+        source = destination;\
+        destination = temporal;\
+    }\
+    uint64_t tasks_size = 0;\
+    lagus_##T##_##E##_build_top (bst -> buffer, source, size, lagus_root, lagus_none, depth, tasks, & tasks_size);\
+    lagus_##T##_##E##_run_tasks (lagus_##T##_##E##_build_task, tasks, handles, tasks_size);\
+    lagus_##T##_##E##_update_top (bst -> buffer, lagus_root, depth);\
+    bst -> height = lagus_##T##_##E##_balanced_height (size);\
+    bst -> memory_management.deallocate (handles);\
+    bst -> memory_management.deallocate (tasks);\
+    bst -> memory_management.deallocate (scratch);\
+    return lagus_success;\
+}\
+\
+static lagus_result lagus_##T##_##E##_add_batch (lagus_##T##_##E * bst, E * elements, uint64_t size, uint8_t direction) {\
+    bst -> modifications ++;\
+    if (size == 0)\
+        return lagus_success;\
+    uint64_t tree_size = bst -> buffer [lagus_root].size;\
+    uint64_t total = tree_size + size;\
+    if (total > bst -> capacity) {\
+        uint64_t capacity = bst -> capacity;\
+        while (capacity < total)\
+            capacity <<= 1;\
+        lagus_##T##_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_##T##_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        bst -> capacity = capacity;\
+        bst -> buffer = buffer - 1;\
+    }\
+    bool rebuild = size * lagus_##T##_##E##_balanced_height (total) >= total;\
+    uint64_t scratch_size = size;\
+    if (rebuild)\
+        scratch_size = total + tree_size;\
+    E * scratch = bst -> memory_management.allocate (_Alignof (E), scratch_size * sizeof (E));\
+    if (! scratch)\
+        return lagus_memory_allocation;\
+    lagus_##T##_##E##_sort (bst, elements, scratch, size);\
+    if (rebuild) {\
+        E * tree = scratch + total;\
+        if (tree_size)\
+            lagus_##T##_##E##_flatten (bst -> buffer, lagus_root, tree);\
+        if (direction == lagus_left)\
+            lagus_##T##_##E##_merge (bst, elements, size, tree, tree_size, scratch);\
+        else\
+            lagus_##T##_##E##_merge (bst, tree, tree_size, elements, size, scratch);\
+        lagus_##T##_##E##_build_subtree (bst -> buffer, scratch, total, lagus_root, lagus_none);\
+        bst -> height = lagus_##T##_##E##_balanced_height (total);\
+        bst -> memory_management.deallocate (scratch);\
+        return lagus_success;\
+    }\
+    bst -> memory_management.deallocate (scratch);\
+    uint64_t rank = 0;\
+    if (direction == lagus_left)\
+        rank = tree_size;\
+    for (uint64_t index = 0; index < size; index ++) {\
+        lagus_result result;\
+        if (direction == lagus_left)\
+            result = lagus_##T##_##E##_add_hint (bst, rank, elements [size - 1 - index], lagus_left, & rank);\
+        else\
+            result = lagus_##T##_##E##_add_hint (bst, rank + 1, elements [index], lagus_right, & rank);\
+        if (result != lagus_success)\
+            return result;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_add_batch_left (lagus_##T##_##E * bst, E * elements, uint64_t size) {\
+    return lagus_##T##_##E##_add_batch (bst, elements, size, lagus_left);\
+}\
+\
+lagus_result lagus_##T##_##E##_add_batch_right (lagus_##T##_##E * bst, E * elements, uint64_t size) {\
+    return lagus_##T##_##E##_add_batch (bst, elements, size, lagus_right);\
+}\
+\
+lagus_result lagus_##T##_##E##_search_left (lagus_##T##_##E * bst, E * element, uint64_t * index) {\
+    if (bst -> height == 0)\
         return lagus_not_contained;\
     uint64_t offset = 0;\
     uint64_t match = lagus_none;\
     uint64_t node = lagus_root;\
     while (true) {\
         uint64_t child;\
-        int64_t comparison = bst -> compare (* element, bst -> buffer [node].element);\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [node].element);\
         if (comparison == 0) {\
             child = bst -> buffer [node].left_child;\
             if (! child) {\
@@ -1986,7 +2643,7 @@ lagus_result lagus_bst_##E##_search_left (lagus_bst_##E * bst, E * element, uint
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_search_right (lagus_bst_##E * bst, E * element, uint64_t * index) {\
+lagus_result lagus_##T##_##E##_search_right (lagus_##T##_##E * bst, E * element, uint64_t * index) {\
     if (bst -> height == 0)\
         return lagus_not_contained;\
     uint64_t offset = 0;\
@@ -1994,7 +2651,7 @@ lagus_result lagus_bst_##E##_search_right (lagus_bst_##E * bst, E * element, uin
     uint64_t node = lagus_root;\
     while (true) {\
         uint64_t child;\
-        int64_t comparison = bst -> compare (* element, bst -> buffer [node].element);\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [node].element);\
         if (comparison == 0) {\
             child = bst -> buffer [node].right_child;\
             uint64_t left_child = bst -> buffer [node].left_child;\
@@ -2030,57 +2687,259 @@ lagus_result lagus_bst_##E##_search_right (lagus_bst_##E * bst, E * element, uin
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element) {\
-    if (bst -> height == 0)\
-        return lagus_not_contained;\
-    if (bst -> height == 1) {\
-        int64_t comparison = bst -> compare (* element, bst -> buffer [lagus_root].element);\
-        if (comparison == 0) {\
-            bst -> height = 0;\
-            bst -> buffer [lagus_root].size = 0;\
-            * element = bst -> buffer [lagus_root].element;\
-            return lagus_success;\
+static lagus_result lagus_##T##_##E##_search_batch (lagus_##T##_##E * bst, E * elements, uint64_t * indices, lagus_result * results, uint64_t size, uint8_t direction) {\
+    if (bst -> height == 0) {\
+        for (uint64_t probe = 0; probe < size; probe ++)\
+            results [probe] = lagus_not_contained;\
+        return lagus_success;\
+    }\
+    uint64_t probes [lagus_bst_batch_width];\
+    uint64_t nodes [lagus_bst_batch_width];\
+    uint64_t offsets [lagus_bst_batch_width];\
+    uint64_t carries [lagus_bst_batch_width];\
+    uint64_t matches [lagus_bst_batch_width];\
+    uint64_t positions [lagus_bst_batch_width];\
+    bool rights [lagus_bst_batch_width];\
+    bool pending [lagus_bst_batch_width];\
+    uint64_t next = 0;\
+    uint64_t active = 0;\
+    while (active < lagus_bst_batch_width && next < size) {\
+        probes [active] = next;\
+        nodes [active] = lagus_root;\
+        offsets [active] = 0;\
+        matches [active] = lagus_none;\
+        rights [active] = false;\
+        pending [active] = false;\
+        active ++;\
+        next ++;\
+    }\
+    uint64_t slot = 0;\
+    while (active) {\
+        uint64_t node = nodes [slot];\
+        uint64_t node_size = node ? bst -> buffer [node].size : 0;\
+        if (rights [slot])\
+            offsets [slot] += carries [slot] - node_size;\
+        if (pending [slot]) {\
+            positions [slot] = rights [slot] ? offsets [slot] : offsets [slot] + node_size + 1;\
+            pending [slot] = false;\
+        }\
+        if (node) {\
+            uint64_t probe = probes [slot];\
+            int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, elements [probe], bst -> buffer [node].element);\
+            if (comparison == 0) {\
+                matches [slot] = node;\
+                pending [slot] = true;\
+            }\
+            rights [slot] = comparison > 0 || comparison == 0 && direction == lagus_right;\
+            if (rights [slot]) {\
+                carries [slot] = node_size;\
+                node = bst -> buffer [node].right_child;\
+            } else\
+                node = bst -> buffer [node].left_child;\
+            nodes [slot] = node;\
+            if (node)\
+                __builtin_prefetch (bst -> buffer + node);\
+            slot ++;\
+            if (slot == active)\
+                slot = 0;\
+            continue;\
+        }\
+        uint64_t probe = probes [slot];\
+        if (matches [slot]) {\
+            elements [probe] = bst -> buffer [matches [slot]].element;\
+            indices [probe] = positions [slot];\
+            results [probe] = lagus_success;\
+        } else\
+            results [probe] = lagus_not_contained;\
+        if (next < size) {\
+            probes [slot] = next;\
+            nodes [slot] = lagus_root;\
+            offsets [slot] = 0;\
+            matches [slot] = lagus_none;\
+            rights [slot] = false;\
+            pending [slot] = false;\
+            next ++;\
+        } else {\
+            active --;\
+            probes [slot] = probes [active];\
+            nodes [slot] = nodes [active];\
+            offsets [slot] = offsets [active];\
+            carries [slot] = carries [active];\
+            matches [slot] = matches [active];\
+            positions [slot] = positions [active];\
+            rights [slot] = rights [active];\
+            pending [slot] = pending [active];\
+            if (slot == active)\
+                slot = 0;\
         }\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_search_batch_left (lagus_##T##_##E * bst, E * elements, uint64_t * indices, lagus_result * results, uint64_t size) {\
+    return lagus_##T##_##E##_search_batch (bst, elements, indices, results, size, lagus_left);\
+}\
+\
+lagus_result lagus_##T##_##E##_search_batch_right (lagus_##T##_##E * bst, E * elements, uint64_t * indices, lagus_result * results, uint64_t size) {\
+    return lagus_##T##_##E##_search_batch (bst, elements, indices, results, size, lagus_right);\
+}\
+\
+static lagus_result lagus_##T##_##E##_search_below (lagus_##T##_##E * bst, E * element, uint64_t * index, bool inclusive) {\
+    if (bst -> height == 0)\
         return lagus_not_contained;\
+    uint64_t offset = 0;\
+    uint64_t match = lagus_none;\
+    uint64_t node = lagus_root;\
+    while (node) {\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [node].element);\
+        if (comparison > 0 || inclusive && comparison == 0) {\
+            uint64_t left_child = bst -> buffer [node].left_child;\
+            if (left_child)\
+                offset += bst -> buffer [left_child].size + 1;\
+            else\
+                offset ++;\
+            match = node;\
+            * index = offset;\
+            node = bst -> buffer [node].right_child;\
+        } else\
+            node = bst -> buffer [node].left_child;\
     }\
-    uint64_t child;\
+    if (! match)\
+        return lagus_not_contained;\
+    * element = bst -> buffer [match].element;\
+    return lagus_success;\
+}\
+\
+static lagus_result lagus_##T##_##E##_search_above (lagus_##T##_##E * bst, E * element, uint64_t * index, bool inclusive) {\
+    if (bst -> height == 0)\
+        return lagus_not_contained;\
+    uint64_t offset = 0;\
     uint64_t match = lagus_none;\
     uint64_t node = lagus_root;\
-    while (true) {\
-        int64_t comparison = bst -> compare (* element, bst -> buffer [node].element);\
-        if (comparison == 0) {\
-            child = bst -> buffer [node].left_child;\
-            if (! child) {\
-                * element = bst -> buffer [node].element;\
-                child = bst -> buffer [node].right_child;\
-                break;\
-            }\
+    while (node) {\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [node].element);\
+        uint64_t left_child = bst -> buffer [node].left_child;\
+        if (comparison < 0 || inclusive && comparison == 0) {\
             match = node;\
+            if (left_child)\
+                * index = offset + bst -> buffer [left_child].size + 1;\
+            else\
+                * index = offset + 1;\
+            node = left_child;\
         } else {\
-            if (comparison < 0) {\
-                child = bst -> buffer [node].left_child;\
-            } else\
-                child = bst -> buffer [node].right_child;\
-            if (! child) {\
-                if (! match)\
-                    return lagus_not_contained;\
-                * element = bst -> buffer [match].element;\
-                bst -> buffer [match].element = bst -> buffer [node].element;\
-                child = bst -> buffer [node].left_child;\
-                break;\
-            }\
+            if (left_child)\
+                offset += bst -> buffer [left_child].size + 1;\
+            else\
+                offset ++;\
+            node = bst -> buffer [node].right_child;\
         }\
-        node = child;\
     }\
-    if (child) {\
-        bst -> buffer [node].element = bst -> buffer [child].element;\
-        node = child;\
+    if (! match)\
+        return lagus_not_contained;\
+    * element = bst -> buffer [match].element;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_search_floor (lagus_##T##_##E * bst, E * element, uint64_t * index) {\
+    return lagus_##T##_##E##_search_below (bst, element, index, true);\
+}\
+\
+lagus_result lagus_##T##_##E##_search_ceiling (lagus_##T##_##E * bst, E * element, uint64_t * index) {\
+    return lagus_##T##_##E##_search_above (bst, element, index, true);\
+}\
+\
+lagus_result lagus_##T##_##E##_search_predecessor (lagus_##T##_##E * bst, E * element, uint64_t * index) {\
+    return lagus_##T##_##E##_search_below (bst, element, index, false);\
+}\
+\
+lagus_result lagus_##T##_##E##_search_successor (lagus_##T##_##E * bst, E * element, uint64_t * index) {\
+    return lagus_##T##_##E##_search_above (bst, element, index, false);\
+}\
+\
+static uint64_t lagus_##T##_##E##_rank (lagus_##T##_##E * bst, E * element, bool inclusive) {\
+    if (bst -> height == 0)\
+        return 0;\
+    uint64_t offset = 0;\
+    uint64_t node = lagus_root;\
+    while (node) {\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [node].element);\
+        if (comparison > 0 || inclusive && comparison == 0) {\
+            uint64_t left_child = bst -> buffer [node].left_child;\
+            if (left_child)\
+                offset += bst -> buffer [left_child].size + 1;\
+            else\
+                offset ++;\
+            node = bst -> buffer [node].right_child;\
+        } else\
+            node = bst -> buffer [node].left_child;\
     }\
-    \
+    return offset;\
+}\
+\
+lagus_result lagus_##T##_##E##_rank_left (lagus_##T##_##E * bst, E * element, uint64_t * index) {\
+    * index = lagus_##T##_##E##_rank (bst, element, false) + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_rank_right (lagus_##T##_##E * bst, E * element, uint64_t * index) {\
+    * index = lagus_##T##_##E##_rank (bst, element, true) + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_count_range (lagus_##T##_##E * bst, E * lower, E * upper, uint64_t * count) {\
+    uint64_t a = lagus_##T##_##E##_rank (bst, lower, false);\
+    uint64_t b = lagus_##T##_##E##_rank (bst, upper, true);\
+    if (b > a)\
+        * count = b - a;\
+    else\
+        * count = 0;\
+    return lagus_success;\
+}\
+\
+static E * lagus_##T##_##E##_gather (lagus_##T##_node_##E * buffer, uint64_t node, uint64_t * state, uint64_t count, E * output) {\
+    while (count) {\
+        uint64_t left_child = buffer [node].left_child;\
+        uint64_t left_size = 0;\
+        if (left_child)\
+            left_size = buffer [left_child].size;\
+        uint64_t size = buffer [node].size;\
+        uint64_t left = 0;\
+        uint64_t picked = 0;\
+        for (uint64_t draw = 0; draw < count; draw ++) {\
+            uint64_t pick = (__uint128_t) lagus_random (state) * (size - draw) >> 64;\
+            if (pick < left_size - left)\
+                left ++;\
+            else if (! picked && pick == left_size - left)\
+                picked = 1;\
+        }\
+        if (left)\
+            output = lagus_##T##_##E##_gather (buffer, left_child, state, left, output);\
+        if (picked) {\
+            * output = buffer [node].element;\
+            output ++;\
+        }\
+        count -= left + picked;\
+        node = buffer [node].right_child;\
+    }\
+    return output;\
+}\
+\
+lagus_result lagus_##T##_##E##_sample_distinct (lagus_##T##_##E * bst, uint64_t * state, E * elements, uint64_t count) {\
+    if (count > bst -> buffer [lagus_root].size)\
+        return lagus_not_contained;\
+    if (! count)\
+        return lagus_success;\
+    lagus_##T##_##E##_gather (bst -> buffer, lagus_root, state, count, elements);\
+    return lagus_success;\
+}\
+\
+static lagus_result lagus_##T##_##E##_remove_leaf (lagus_##T##_##E * bst, uint64_t node) {\
+    uint64_t child;\
     uint8_t direction;\
     uint64_t parent = bst -> buffer [node].parent;\
     uint64_t size = bst -> buffer [lagus_root].size;\
     if (parent == size) {\
+        bst -> buffer [node].size = bst -> buffer [parent].size;\
         bst -> buffer [node].configuration = bst -> buffer [parent].configuration;\
         bst -> buffer [node].element = bst -> buffer [parent].element;\
         if (bst -> buffer [parent].left_child == node) {\
@@ -2161,6 +3020,8 @@ lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element) {\
                     E temporal = bst -> buffer [node].element;\
                     bst -> buffer [node].element = bst -> buffer [b].element;\
                     bst -> buffer [b].element = temporal;\
+                    U (bst -> buffer, a);\
+                    U (bst -> buffer, b);\
                     if (bst -> buffer [b].configuration == 0b00) {\
                         bst -> buffer [a].configuration = 0b00;\
                     } else if (bst -> buffer [b].configuration == 0b10) {\
@@ -2190,6 +3051,7 @@ lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element) {\
                     E temporal = bst -> buffer [node].element;\
                     bst -> buffer [node].element = bst -> buffer [b].element;\
                     bst -> buffer [b].element = temporal;\
+                    U (bst -> buffer, b);\
                     if (bst -> buffer [child].configuration == 0b00) {\
                         bst -> buffer [child].configuration = 0b10;\
                         bst -> buffer [node].configuration = 0b01;\
@@ -2226,6 +3088,8 @@ lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element) {\
                     E temporal = bst -> buffer [node].element;\
                     bst -> buffer [node].element = bst -> buffer [b].element;\
                     bst -> buffer [b].element = temporal;\
+                    U (bst -> buffer, c);\
+                    U (bst -> buffer, b);\
                     if (bst -> buffer [b].configuration == 0b00) {\
                         bst -> buffer [c].configuration = 0b00;\
                     } else if (bst -> buffer [b].configuration == 0b01) {\
@@ -2254,6 +3118,7 @@ lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element) {\
                     E temporal = bst -> buffer [node].element;\
                     bst -> buffer [node].element = bst -> buffer [b].element;\
                     bst -> buffer [b].element = temporal;\
+                    U (bst -> buffer, b);\
                     if (bst -> buffer [child].configuration == 0b00) {\
                         bst -> buffer [child].configuration = 0b01;\
                         bst -> buffer [node].configuration = 0b10;\
@@ -2265,6 +3130,7 @@ lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element) {\
             }\
         }\
         bst -> buffer [node].configuration = 0b00;\
+        U (bst -> buffer, node);\
         if (node == lagus_root) {\
             bst -> height --;\
             return lagus_success;\
@@ -2276,18 +3142,19 @@ lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element) {\
         else\
             direction = lagus_right;\
     }\
+    U (bst -> buffer, node);\
     while (node != lagus_root) {\
         node = bst -> buffer [node].parent;\
         bst -> buffer [node].size --;\
+        U (bst -> buffer, node);\
     }\
-    \
     uint64_t capacity;\
     if (bst -> capacity < 4)\
         capacity = 1;\
     else\
         capacity = bst -> capacity >> 2;\
     if (size <= capacity) {\
-        lagus_bst_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_bst_node_##E));\
+        lagus_##T##_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_##T##_node_##E));\
         if (! buffer)\
             return lagus_memory_allocation;\
         bst -> capacity = capacity;\
@@ -2296,11 +3163,62 @@ lagus_result lagus_bst_##E##_remove_left (lagus_bst_##E * bst, E * element) {\
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_remove_right (lagus_bst_##E * bst, E * element) {\
+lagus_result lagus_##T##_##E##_remove_left (lagus_##T##_##E * bst, E * element) {\
+    bst -> modifications ++;\
+    if (bst -> height == 0)\
+        return lagus_not_contained;\
+    if (bst -> height == 1) {\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [lagus_root].element);\
+        if (comparison == 0) {\
+            bst -> height = 0;\
+            bst -> buffer [lagus_root].size = 0;\
+            * element = bst -> buffer [lagus_root].element;\
+            return lagus_success;\
+        }\
+        return lagus_not_contained;\
+    }\
+    uint64_t child;\
+    uint64_t match = lagus_none;\
+    uint64_t node = lagus_root;\
+    while (true) {\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [node].element);\
+        if (comparison == 0) {\
+            child = bst -> buffer [node].left_child;\
+            if (! child) {\
+                * element = bst -> buffer [node].element;\
+                child = bst -> buffer [node].right_child;\
+                break;\
+            }\
+            match = node;\
+        } else {\
+            if (comparison < 0) {\
+                child = bst -> buffer [node].left_child;\
+            } else\
+                child = bst -> buffer [node].right_child;\
+            if (! child) {\
+                if (! match)\
+                    return lagus_not_contained;\
+                * element = bst -> buffer [match].element;\
+                bst -> buffer [match].element = bst -> buffer [node].element;\
+                child = bst -> buffer [node].left_child;\
+                break;\
+            }\
+        }\
+        node = child;\
+    }\
+    if (child) {\
+        bst -> buffer [node].element = bst -> buffer [child].element;\
+        node = child;\
+    }\
+    return lagus_##T##_##E##_remove_leaf (bst, node);\
+}\
+\
+lagus_result lagus_##T##_##E##_remove_right (lagus_##T##_##E * bst, E * element) {\
+    bst -> modifications ++;\
     if (bst -> height == 0)\
         return lagus_not_contained;\
     if (bst -> height == 1) {\
-        int64_t comparison = bst -> compare (* element, bst -> buffer [lagus_root].element);\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [lagus_root].element);\
         if (comparison == 0) {\
             bst -> height = 0;\
             bst -> buffer [lagus_root].size = 0;\
@@ -2313,7 +3231,7 @@ lagus_result lagus_bst_##E##_remove_right (lagus_bst_##E * bst, E * element) {\
     uint64_t match = lagus_none;\
     uint64_t node = lagus_root;\
     while (true) {\
-        int64_t comparison = bst -> compare (* element, bst -> buffer [node].element);\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, bst -> buffer [node].element);\
         if (comparison == 0) {\
             child = bst -> buffer [node].right_child;\
             if (! child) {\
@@ -2342,226 +3260,11 @@ lagus_result lagus_bst_##E##_remove_right (lagus_bst_##E * bst, E * element) {\
         bst -> buffer [node].element = bst -> buffer [child].element;\
         node = child;\
     }\
-    \
-    uint8_t direction;\
-    uint64_t parent = bst -> buffer [node].parent;\
-    uint64_t size = bst -> buffer [lagus_root].size;\
-    if (parent == size) {\
-        bst -> buffer [node].configuration = bst -> buffer [parent].configuration;\
-        bst -> buffer [node].element = bst -> buffer [parent].element;\
-        if (bst -> buffer [parent].left_child == node) {\
-            direction = lagus_left;\
-            child = bst -> buffer [parent].right_child;\
-            bst -> buffer [node].right_child = child;\
-        } else {\
-            direction = lagus_right;\
-            child = bst -> buffer [parent].left_child;\
-            bst -> buffer [node].left_child = child;\
-        }\
-        if (child)\
-            bst -> buffer [child].parent = node;\
-        parent = bst -> buffer [parent].parent;\
-        bst -> buffer [node].parent = parent;\
-        if (bst -> buffer [parent].left_child == size)\
-            bst -> buffer [parent].left_child = node;\
-        else\
-            bst -> buffer [parent].right_child = node;\
-    } else {\
-        if (bst -> buffer [parent].left_child == node) {\
-            direction = lagus_left;\
-            bst -> buffer [parent].left_child = lagus_none;\
-        } else {\
-            direction = lagus_right;\
-            bst -> buffer [parent].right_child = lagus_none;\
-        }\
-        if (node != size) {\
-            bst -> buffer [node] = bst -> buffer [size];\
-            uint64_t parent = bst -> buffer [node].parent;\
-            if (bst -> buffer [parent].left_child == size)\
-                bst -> buffer [parent].left_child = node;\
-            else\
-                bst -> buffer [parent].right_child = node;\
-            child = bst -> buffer [node].left_child;\
-            if (child)\
-                bst -> buffer [child].parent = node;\
-            child = bst -> buffer [node].right_child;\
-            if (child)\
-                bst -> buffer [child].parent = node;\
-        }\
-        node = parent;\
-    }\
-    size --;\
-    \
-    while (true) {\
-        bst -> buffer [node].size --;\
-        if (bst -> buffer [node].configuration == 0b00) {\
-            if (direction == lagus_left)\
-                bst -> buffer [node].configuration = 0b01;\
-            else\
-                bst -> buffer [node].configuration = 0b10;\
-            break;\
-        } else if (bst -> buffer [node].configuration == 0b10) {\
-            if (direction == lagus_right) {\
-                child = bst -> buffer [node].left_child;\
-                if (bst -> buffer [child].configuration == 0b01) {\
-                    uint64_t a = child;\
-                    uint64_t b = bst -> buffer [a].right_child;\
-                    bst -> buffer [a].size -= bst -> buffer [b].size;\
-                    uint64_t Y = bst -> buffer [b].left_child;\
-                    bst -> buffer [a].right_child = Y;\
-                    if (Y) {\
-                        bst -> buffer [Y].parent = a;\
-                        bst -> buffer [a].size += bst -> buffer [Y].size;\
-                        bst -> buffer [b].size -= bst -> buffer [Y].size;\
-                    }\
-                    uint64_t X = bst -> buffer [b].right_child;\
-                    bst -> buffer [b].left_child = X;\
-                    uint64_t W = bst -> buffer [node].right_child;\
-                    bst -> buffer [b].right_child = W;\
-                    if (W) {\
-                        bst -> buffer [W].parent = b;\
-                        bst -> buffer [b].size += bst -> buffer [W].size;\
-                    }\
-                    bst -> buffer [node].right_child = b;\
-                    bst -> buffer [b].parent = node;\
-                    E temporal = bst -> buffer [node].element;\
-                    bst -> buffer [node].element = bst -> buffer [b].element;\
-                    bst -> buffer [b].element = temporal;\
-                    if (bst -> buffer [b].configuration == 0b00) {\
-                        bst -> buffer [a].configuration = 0b00;\
-                    } else if (bst -> buffer [b].configuration == 0b10) {\
-                        bst -> buffer [a].configuration = 0b00;\
-                        bst -> buffer [b].configuration = 0b01;\
-                    } else {\
-                        bst -> buffer [a].configuration = 0b10;\
-                        bst -> buffer [b].configuration = 0b00;\
-                    }\
-                } else {\
-                    \
-                    uint64_t b = child;\
-                    uint64_t a = bst -> buffer [b].left_child;\
-                    bst -> buffer [b].size -= bst -> buffer [a].size;\
-                    uint64_t X = bst -> buffer [b].right_child;\
-                    bst -> buffer [b].left_child = X;\
-                    uint64_t W = bst -> buffer [node].right_child;\
-                    bst -> buffer [b].right_child = W;\
-                    if (W) {\
-                        bst -> buffer [W].parent = b;\
-                        bst -> buffer [b].size += bst -> buffer [W].size;\
-                    }\
-                    bst -> buffer [node].left_child = a;\
-                    bst -> buffer [a].parent = node;\
-                    bst -> buffer [node].right_child = b;\
-                    bst -> buffer [b].parent = node;\
-                    E temporal = bst -> buffer [node].element;\
-                    bst -> buffer [node].element = bst -> buffer [b].element;\
-                    bst -> buffer [b].element = temporal;\
-                    if (bst -> buffer [child].configuration == 0b00) {\
-                        bst -> buffer [child].configuration = 0b10;\
-                        bst -> buffer [node].configuration = 0b01;\
-                        break;\
-                    } else\
-                        bst -> buffer [child].configuration = 0b00;\
-                    \
-                }\
-            }\
-        } else {\
-            if (direction == lagus_left) {\
-                child = bst -> buffer [node].right_child;\
-                if (bst -> buffer [child].configuration == 0b10) {\
-                    uint64_t c = child;\
-                    uint64_t b = bst -> buffer [c].left_child;\
-                    bst -> buffer [c].size -= bst -> buffer [b].size;\
-                    uint64_t X = bst -> buffer [b].right_child;\
-                    bst -> buffer [c].left_child = X;\
-                    if (X) {\
-                        bst -> buffer [X].parent = c;\
-                        bst -> buffer [c].size += bst -> buffer [X].size;\
-                        bst -> buffer [b].size -= bst -> buffer [X].size;\
-                    }\
-                    uint64_t Y = bst -> buffer [b].left_child;\
-                    bst -> buffer [b].right_child = Y;\
-                    uint64_t Z = bst -> buffer [node].left_child;\
-                    bst -> buffer [b].left_child = Z;\
-                    if (Z) {\
-                        bst -> buffer [Z].parent = b;\
-                        bst -> buffer [b].size += bst -> buffer [Z].size;\
-                    }\
-                    bst -> buffer [node].left_child = b;\
-                    bst -> buffer [b].parent = node;\
-                    E temporal = bst -> buffer [node].element;\
-                    bst -> buffer [node].element = bst -> buffer [b].element;\
-                    bst -> buffer [b].element = temporal;\
-                    if (bst -> buffer [b].configuration == 0b00) {\
-                        bst -> buffer [c].configuration = 0b00;\
-                    } else if (bst -> buffer [b].configuration == 0b01) {\
-                        bst -> buffer [c].configuration = 0b00;\
-                        bst -> buffer [b].configuration = 0b10;\
-                    } else {\
-                        bst -> buffer [c].configuration = 0b01;\
-                        bst -> buffer [b].configuration = 0b00;\
-                    }\
-                } else {\
-                    uint64_t b = child;\
-                    uint64_t c = bst -> buffer [b].right_child;\
-                    bst -> buffer [b].size -= bst -> buffer [c].size;\
-                    uint64_t Y = bst -> buffer [b].left_child;\
-                    bst -> buffer [b].right_child = Y;\
-                    uint64_t Z = bst -> buffer [node].left_child;\
-                    bst -> buffer [b].left_child = Z;\
-                    if (Z) {\
-                        bst -> buffer [Z].parent = b;\
-                        bst -> buffer [b].size += bst -> buffer [Z].size;\
-                    }\
-                    bst -> buffer [node].right_child = c;\
-                    bst -> buffer [c].parent = node;\
-                    bst -> buffer [node].left_child = b;\
-                    bst -> buffer [b].parent = node;\
-                    E temporal = bst -> buffer [node].element;\
-                    bst -> buffer [node].element = bst -> buffer [b].element;\
-                    bst -> buffer [b].element = temporal;\
-                    if (bst -> buffer [child].configuration == 0b00) {\
-                        bst -> buffer [child].configuration = 0b01;\
-                        bst -> buffer [node].configuration = 0b10;\
-                        break;\
-                    } else\
-                        bst -> buffer [child].configuration = 0b00;\
-                    \
-                }\
-            }\
-        }\
-        bst -> buffer [node].configuration = 0b00;\
-        if (node == lagus_root) {\
-            bst -> height --;\
-            return lagus_success;\
-        }\
-        child = node;\
-        node = bst -> buffer [node].parent;\
-        if (bst -> buffer [node].left_child == child)\
-            direction = lagus_left;\
-        else\
-            direction = lagus_right;\
-    }\
-    while (node != lagus_root) {\
-        node = bst -> buffer [node].parent;\
-        bst -> buffer [node].size --;\
-    }\
-    uint64_t capacity;\
-    if (bst -> capacity < 4)\
-        capacity = 1;\
-    else\
-        capacity = bst -> capacity >> 2;\
-    if (size <= capacity) {\
-        lagus_bst_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_bst_node_##E));\
-        if (! buffer)\
-            return lagus_memory_allocation;\
-        bst -> capacity = capacity;\
-        bst -> buffer = buffer - 1;\
-    }\
-    return lagus_success;\
+    return lagus_##T##_##E##_remove_leaf (bst, node);\
 }\
 \
-lagus_result lagus_bst_##E##_remove_at (lagus_bst_##E * bst, uint64_t index, E * element) {\
+lagus_result lagus_##T##_##E##_remove_at (lagus_##T##_##E * bst, uint64_t index, E * element) {\
+    bst -> modifications ++;\
     if (bst -> height == 1) {\
         bst -> height = 0;\
         bst -> buffer [lagus_root].size = 0;\
@@ -2615,279 +3318,3083 @@ lagus_result lagus_bst_##E##_remove_at (lagus_bst_##E * bst, uint64_t index, E *
             node = child;\
         }\
     }\
-    uint8_t direction;\
-    uint64_t parent = bst -> buffer [node].parent;\
-    uint64_t size = bst -> buffer [lagus_root].size;\
-    if (parent == size) {\
-        bst -> buffer [node].configuration = bst -> buffer [parent].configuration;\
-        bst -> buffer [node].element = bst -> buffer [parent].element;\
-        if (bst -> buffer [parent].left_child == node) {\
-            direction = lagus_left;\
-            child = bst -> buffer [parent].right_child;\
-            bst -> buffer [node].right_child = child;\
-        } else {\
-            direction = lagus_right;\
-            child = bst -> buffer [parent].left_child;\
-            bst -> buffer [node].left_child = child;\
-        }\
-        if (child)\
-            bst -> buffer [child].parent = node;\
-        parent = bst -> buffer [parent].parent;\
-        bst -> buffer [node].parent = parent;\
-        if (bst -> buffer [parent].left_child == size)\
-            bst -> buffer [parent].left_child = node;\
+    return lagus_##T##_##E##_remove_leaf (bst, node);\
+}\
+\
+lagus_result lagus_##T##_##E##_get_at (lagus_##T##_##E * bst, uint64_t index, E * element) {\
+    uint64_t node = lagus_root;\
+    while (true) {\
+        uint64_t left_child = bst -> buffer [node].left_child;\
+        uint64_t size;\
+        if (left_child)\
+            size = bst -> buffer [left_child].size;\
         else\
-            bst -> buffer [parent].right_child = node;\
-    } else {\
-        if (bst -> buffer [parent].left_child == node) {\
-            direction = lagus_left;\
-            bst -> buffer [parent].left_child = lagus_none;\
-        } else {\
-            direction = lagus_right;\
-            bst -> buffer [parent].right_child = lagus_none;\
+            size = 0;\
+        if (index == size + 1) {\
+            * element = bst -> buffer [node].element;\
+            return lagus_success;\
         }\
-        if (node != size) {\
-            bst -> buffer [node] = bst -> buffer [size];\
-            uint64_t parent = bst -> buffer [node].parent;\
-            if (bst -> buffer [parent].left_child == size)\
-                bst -> buffer [parent].left_child = node;\
-            else\
-                bst -> buffer [parent].right_child = node;\
-            child = bst -> buffer [node].left_child;\
-            if (child)\
-                bst -> buffer [child].parent = node;\
-            child = bst -> buffer [node].right_child;\
-            if (child)\
-                bst -> buffer [child].parent = node;\
+        if (index <= size)\
+            node = left_child;\
+        else {\
+            index -= size + 1;\
+            node = bst -> buffer [node].right_child;\
         }\
-        node = parent;\
     }\
-    size --;\
-    \
+}\
+\
+static void lagus_##T##_##E##_split_nodes (lagus_##T##_##E * bst, lagus_##T##_node_##E * buffer, uint64_t node, uint64_t height, E * element, uint8_t direction, uint64_t * left, uint64_t * left_height, uint64_t * right, uint64_t * right_height) {\
+    if (! node) {\
+        * left = lagus_none;\
+        * left_height = 0;\
+        * right = lagus_none;\
+        * right_height = 0;\
+        return;\
+    }\
+    uint64_t a_height, b_height;\
+    lagus_##T##_##E##_child_heights (buffer, node, height, & a_height, & b_height);\
+    uint64_t a = buffer [node].left_child;\
+    uint64_t b = buffer [node].right_child;\
+    int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * element, buffer [node].element);\
+    if (comparison < 0 || direction == lagus_left && comparison == 0) {\
+        lagus_##T##_##E##_split_nodes (bst, buffer, a, a_height, element, direction, left, left_height, & a, & a_height);\
+        * right = lagus_##T##_##E##_join_nodes (buffer, a, a_height, node, b, b_height, right_height);\
+    } else {\
+        lagus_##T##_##E##_split_nodes (bst, buffer, b, b_height, element, direction, & b, & b_height, right, right_height);\
+        * left = lagus_##T##_##E##_join_nodes (buffer, a, a_height, node, b, b_height, left_height);\
+    }\
+}\
+\
+static uint64_t lagus_##T##_##E##_move_subtree (lagus_##T##_node_##E * source, uint64_t node, lagus_##T##_node_##E * destination, uint64_t position, uint64_t parent) {\
     while (true) {\
-        bst -> buffer [node].size --;\
-        if (bst -> buffer [node].configuration == 0b00) {\
-            if (direction == lagus_left)\
-                bst -> buffer [node].configuration = 0b01;\
+        uint64_t left_child = source [node].left_child;\
+        uint64_t right_child = source [node].right_child;\
+        destination [position] = source [node];\
+        destination [position].parent = parent;\
+        source [node].size = 0;\
+        uint64_t next = position + 1;\
+        if (left_child) {\
+            destination [position].left_child = next;\
+            next = lagus_##T##_##E##_move_subtree (source, left_child, destination, next, position);\
+        }\
+        if (! right_child)\
+            return next;\
+        destination [position].right_child = next;\
+        parent = position;\
+        position = next;\
+        node = right_child;\
+    }\
+}\
+\
+static lagus_result lagus_##T##_##E##_split (lagus_##T##_##E * bst, E * element, uint64_t count, uint8_t direction, lagus_##T##_##E * other) {\
+    bst -> modifications ++;\
+    other -> modifications ++;\
+    uint64_t size = bst -> buffer [lagus_root].size;\
+    if (element)\
+        count = lagus_##T##_##E##_rank (bst, element, direction == lagus_right);\
+    if (count > size)\
+        count = size;\
+    uint64_t other_size = size - count;\
+    if (other_size > other -> capacity) {\
+        lagus_##T##_node_##E * buffer = other -> memory_management.allocate (_Alignof (lagus_##T##_node_##E), other_size * sizeof (lagus_##T##_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        other -> memory_management.deallocate (other -> buffer + 1);\
+        other -> capacity = other_size;\
+        other -> buffer = buffer - 1;\
+    }\
+    other -> height = 0;\
+    other -> buffer [lagus_root] = (lagus_##T##_node_##E) {\
+        .parent = lagus_none,\
+        .left_child = lagus_none,\
+        .right_child = lagus_none,\
+        .size = 0\
+    };\
+    if (other_size == 0)\
+        return lagus_success;\
+    uint64_t left, left_height, right, right_height;\
+    lagus_##T##_##E##_split_count (bst -> buffer, lagus_root, bst -> height, count, & left, & left_height, & right, & right_height);\
+    lagus_##T##_##E##_move_subtree (bst -> buffer, right, other -> buffer, lagus_root, lagus_none);\
+    other -> height = right_height;\
+    bst -> height = left_height;\
+    if (count == 0) {\
+        bst -> buffer [lagus_root] = (lagus_##T##_node_##E) {\
+            .parent = lagus_none,\
+            .left_child = lagus_none,\
+            .right_child = lagus_none,\
+            .size = 0\
+        };\
+        return lagus_success;\
+    }\
+    bst -> buffer [left].parent = lagus_none;\
+    lagus_##T##_##E##_compact (bst -> buffer, left, size, count);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_split_left (lagus_##T##_##E * bst, E * element, lagus_##T##_##E * other) {\
+    return lagus_##T##_##E##_split (bst, element, 0, lagus_left, other);\
+}\
+\
+lagus_result lagus_##T##_##E##_split_right (lagus_##T##_##E * bst, E * element, lagus_##T##_##E * other) {\
+    return lagus_##T##_##E##_split (bst, element, 0, lagus_right, other);\
+}\
+\
+lagus_result lagus_##T##_##E##_split_at (lagus_##T##_##E * bst, uint64_t index, lagus_##T##_##E * other) {\
+    return lagus_##T##_##E##_split (bst, NULL, index - 1, lagus_left, other);\
+}\
+\
+lagus_result lagus_##T##_##E##_join (lagus_##T##_##E * bst, lagus_##T##_##E * other) {\
+    bst -> modifications ++;\
+    other -> modifications ++;\
+    if (other -> height == 0)\
+        return lagus_success;\
+    uint64_t size = bst -> buffer [lagus_root].size;\
+    uint64_t other_size = other -> buffer [lagus_root].size;\
+    if (bst -> height == 0)\
+        size = 0;\
+    if (size + other_size > bst -> capacity) {\
+        uint64_t capacity = bst -> capacity;\
+        while (capacity < size + other_size)\
+            capacity <<= 1;\
+        lagus_##T##_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_##T##_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        bst -> capacity = capacity;\
+        bst -> buffer = buffer - 1;\
+    }\
+    for (uint64_t index = 1; index <= other_size; index ++) {\
+        lagus_##T##_node_##E node = other -> buffer [index];\
+        if (node.parent)\
+            node.parent += size;\
+        if (node.left_child)\
+            node.left_child += size;\
+        if (node.right_child)\
+            node.right_child += size;\
+        bst -> buffer [size + index] = node;\
+    }\
+    if (size) {\
+        uint64_t height;\
+        uint64_t root = lagus_##T##_##E##_join_pair (bst -> buffer, lagus_root, bst -> height, size + lagus_root, other -> height, & height);\
+        bst -> buffer [root].parent = lagus_none;\
+        if (root != lagus_root)\
+            lagus_##T##_##E##_swap_nodes (bst -> buffer, lagus_root, root);\
+        bst -> height = height;\
+    } else\
+        bst -> height = other -> height;\
+    other -> height = 0;\
+    other -> buffer [lagus_root] = (lagus_##T##_node_##E) {\
+        .parent = lagus_none,\
+        .left_child = lagus_none,\
+        .right_child = lagus_none,\
+        .size = 0\
+    };\
+    return lagus_success;\
+}\
+\
+static lagus_result lagus_##T##_##E##_remove_span (lagus_##T##_##E * bst, uint64_t start, uint64_t end, E * elements) {\
+    bst -> modifications ++;\
+    uint64_t size = bst -> buffer [lagus_root].size;\
+    uint64_t left, left_height, middle, middle_height, right, right_height;\
+    lagus_##T##_##E##_split_count (bst -> buffer, lagus_root, bst -> height, start, & left, & left_height, & right, & right_height);\
+    lagus_##T##_##E##_split_count (bst -> buffer, right, right_height, end - start, & middle, & middle_height, & right, & right_height);\
+    uint64_t removed = 0;\
+    if (middle)\
+        removed = bst -> buffer [middle].size;\
+    if (elements)\
+        lagus_##T##_##E##_flatten (bst -> buffer, middle, elements);\
+    lagus_##T##_##E##_release (bst -> buffer, middle);\
+    uint64_t height;\
+    uint64_t root = lagus_##T##_##E##_join_pair (bst -> buffer, left, left_height, right, right_height, & height);\
+    size -= removed;\
+    bst -> height = height;\
+    if (size == 0)\
+        bst -> buffer [lagus_root] = (lagus_##T##_node_##E) {\
+            .parent = lagus_none,\
+            .left_child = lagus_none,\
+            .right_child = lagus_none,\
+            .size = 0\
+        };\
+    else {\
+        bst -> buffer [root].parent = lagus_none;\
+        lagus_##T##_##E##_compact (bst -> buffer, root, size + removed, size);\
+    }\
+    uint64_t capacity = bst -> capacity;\
+    while (capacity >= 4 && size <= capacity >> 2)\
+        capacity >>= 2;\
+    if (capacity < bst -> capacity) {\
+        lagus_##T##_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_##T##_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        bst -> capacity = capacity;\
+        bst -> buffer = buffer - 1;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_remove_range (lagus_##T##_##E * bst, E * lower, E * upper, E * elements, uint64_t * count) {\
+    * count = 0;\
+    if (bst -> height == 0)\
+        return lagus_success;\
+    uint64_t start = 0;\
+    uint64_t end = bst -> buffer [lagus_root].size;\
+    if (lower)\
+        start = lagus_##T##_##E##_rank (bst, lower, false);\
+    if (upper)\
+        end = lagus_##T##_##E##_rank (bst, upper, true);\
+    if (end <= start)\
+        return lagus_success;\
+    * count = end - start;\
+    return lagus_##T##_##E##_remove_span (bst, start, end, elements);\
+}\
+\
+lagus_result lagus_##T##_##E##_remove_range_at (lagus_##T##_##E * bst, uint64_t first, uint64_t last, E * elements) {\
+    if (first == 0)\
+        return lagus_not_contained;\
+    if (bst -> height == 0)\
+        return lagus_success;\
+    if (last > bst -> buffer [lagus_root].size)\
+        last = bst -> buffer [lagus_root].size;\
+    if (last < first)\
+        return lagus_success;\
+    return lagus_##T##_##E##_remove_span (bst, first - 1, last, elements);\
+}\
+\
+typedef struct lagus_##T##_combination_##E {\
+    lagus_##T##_##E * bst;\
+    lagus_##T##_node_##E * buffer;\
+    uint64_t first;\
+    uint64_t first_height;\
+    uint64_t second;\
+    uint64_t second_height;\
+    uint64_t depth;\
+    uint64_t node;\
+    uint64_t height;\
+    uint8_t operation;\
+} lagus_##T##_combination_##E;\
+\
+static void * lagus_##T##_##E##_combine_task (void * argument) {\
+    lagus_##T##_combination_##E * task = argument;\
+    lagus_##T##_node_##E * buffer = task -> buffer;\
+    if (! task -> first || ! task -> second) {\
+        task -> node = task -> first;\
+        task -> height = task -> first_height;\
+        if (task -> operation == lagus_union && ! task -> first) {\
+            task -> node = task -> second;\
+            task -> height = task -> second_height;\
+        } else if (task -> operation == lagus_intersection) {\
+            lagus_##T##_##E##_release (buffer, task -> first);\
+            lagus_##T##_##E##_release (buffer, task -> second);\
+            task -> node = lagus_none;\
+            task -> height = 0;\
+        } else\
+            lagus_##T##_##E##_release (buffer, task -> second);\
+        return NULL;\
+    }\
+    uint64_t node = task -> first;\
+    E * element = & buffer [node].element;\
+    uint64_t left_height, right_height;\
+    lagus_##T##_##E##_child_heights (buffer, node, task -> first_height, & left_height, & right_height);\
+    uint64_t second_left, second_left_height, rest, rest_height, equal, equal_height, second_right, second_right_height;\
+    lagus_##T##_##E##_split_nodes (task -> bst, buffer, task -> second, task -> second_height, element, lagus_left, & second_left, & second_left_height, & rest, & rest_height);\
+    lagus_##T##_##E##_split_nodes (task -> bst, buffer, rest, rest_height, element, lagus_right, & equal, & equal_height, & second_right, & second_right_height);\
+    uint64_t first_left = buffer [node].left_child;\
+    uint64_t first_right = buffer [node].right_child;\
+    uint64_t run = lagus_none;\
+    uint64_t run_height = 0;\
+    if (equal) {\
+        uint64_t run_left, run_left_height, run_right, run_right_height;\
+        lagus_##T##_##E##_split_nodes (task -> bst, buffer, first_left, left_height, element, lagus_left, & first_left, & left_height, & run_left, & run_left_height);\
+        lagus_##T##_##E##_split_nodes (task -> bst, buffer, first_right, right_height, element, lagus_right, & run_right, & run_right_height, & first_right, & right_height);\
+        run = lagus_##T##_##E##_join_nodes (buffer, run_left, run_left_height, node, run_right, run_right_height, & run_height);\
+        uint64_t count = buffer [run].size;\
+        if (count > buffer [equal].size)\
+            count = buffer [equal].size;\
+        uint64_t kept, kept_height, dropped, dropped_height;\
+        if (task -> operation == lagus_union) {\
+            lagus_##T##_##E##_split_count (buffer, equal, equal_height, count, & dropped, & dropped_height, & kept, & kept_height);\
+            run = lagus_##T##_##E##_join_pair (buffer, run, run_height, kept, kept_height, & run_height);\
+        } else {\
+            lagus_##T##_##E##_release (buffer, equal);\
+            if (task -> operation == lagus_intersection)\
+                lagus_##T##_##E##_split_count (buffer, run, run_height, count, & run, & run_height, & dropped, & dropped_height);\
             else\
-                bst -> buffer [node].configuration = 0b10;\
-            break;\
-        } else if (bst -> buffer [node].configuration == 0b10) {\
-            if (direction == lagus_right) {\
-                child = bst -> buffer [node].left_child;\
-                if (bst -> buffer [child].configuration == 0b01) {\
-                    uint64_t a = child;\
-                    uint64_t b = bst -> buffer [a].right_child;\
-                    bst -> buffer [a].size -= bst -> buffer [b].size;\
-                    uint64_t Y = bst -> buffer [b].left_child;\
-                    bst -> buffer [a].right_child = Y;\
-                    if (Y) {\
-                        bst -> buffer [Y].parent = a;\
-                        bst -> buffer [a].size += bst -> buffer [Y].size;\
-                        bst -> buffer [b].size -= bst -> buffer [Y].size;\
-                    }\
-                    uint64_t X = bst -> buffer [b].right_child;\
-                    bst -> buffer [b].left_child = X;\
-                    uint64_t W = bst -> buffer [node].right_child;\
-                    bst -> buffer [b].right_child = W;\
-                    if (W) {\
-                        bst -> buffer [W].parent = b;\
-                        bst -> buffer [b].size += bst -> buffer [W].size;\
-                    }\
-                    bst -> buffer [node].right_child = b;\
-                    bst -> buffer [b].parent = node;\
-                    E temporal = bst -> buffer [node].element;\
-                    bst -> buffer [node].element = bst -> buffer [b].element;\
-                    bst -> buffer [b].element = temporal;\
-                    if (bst -> buffer [b].configuration == 0b00) {\
-                        bst -> buffer [a].configuration = 0b00;\
-                    } else if (bst -> buffer [b].configuration == 0b10) {\
-                        bst -> buffer [a].configuration = 0b00;\
-                        bst -> buffer [b].configuration = 0b01;\
-                    } else {\
-                        bst -> buffer [a].configuration = 0b10;\
-                        bst -> buffer [b].configuration = 0b00;\
-                    }\
-                } else {\
-                    \
-                    uint64_t b = child;\
-                    uint64_t a = bst -> buffer [b].left_child;\
-                    bst -> buffer [b].size -= bst -> buffer [a].size;\
-                    uint64_t X = bst -> buffer [b].right_child;\
-                    bst -> buffer [b].left_child = X;\
-                    uint64_t W = bst -> buffer [node].right_child;\
-                    bst -> buffer [b].right_child = W;\
-                    if (W) {\
-                        bst -> buffer [W].parent = b;\
-                        bst -> buffer [b].size += bst -> buffer [W].size;\
-                    }\
-                    bst -> buffer [node].left_child = a;\
-                    bst -> buffer [a].parent = node;\
-                    bst -> buffer [node].right_child = b;\
-                    bst -> buffer [b].parent = node;\
-                    E temporal = bst -> buffer [node].element;\
-                    bst -> buffer [node].element = bst -> buffer [b].element;\
-                    bst -> buffer [b].element = temporal;\
-                    if (bst -> buffer [child].configuration == 0b00) {\
-                        bst -> buffer [child].configuration = 0b10;\
-                        bst -> buffer [node].configuration = 0b01;\
-                        break;\
-                    } else\
-                        bst -> buffer [child].configuration = 0b00;\
-                    \
-                }\
+                lagus_##T##_##E##_split_count (buffer, run, run_height, count, & dropped, & dropped_height, & run, & run_height);\
+        }\
+        lagus_##T##_##E##_release (buffer, dropped);\
+    }\
+    lagus_##T##_combination_##E left = {\
+        .bst = task -> bst,\
+        .buffer = buffer,\
+        .first = first_left,\
+        .first_height = left_height,\
+        .second = second_left,\
+        .second_height = second_left_height,\
+        .operation = task -> operation\
+    };\
+    lagus_##T##_combination_##E right = left;\
+    right.first = first_right;\
+    right.first_height = right_height;\
+    right.second = second_right;\
+    right.second_height = second_right_height;\
+    pthread_t thread;\
+    bool started = false;\
+    if (task -> depth) {\
+        left.depth = task -> depth - 1;\
+        right.depth = task -> depth - 1;\
+        started = pthread_create (& thread, NULL, lagus_##T##_##E##_combine_task, & left) == 0;\
+    }\
+    if (! started)\
+        lagus_##T##_##E##_combine_task (& left);\
+    lagus_##T##_##E##_combine_task (& right);\
+    if (started)\
+        pthread_join (thread, NULL);\
+    if (equal) {\
+        task -> node = lagus_##T##_##E##_join_pair (buffer, left.node, left.height, run, run_height, & task -> height);\
+        task -> node = lagus_##T##_##E##_join_pair (buffer, task -> node, task -> height, right.node, right.height, & task -> height);\
+    } else if (task -> operation != lagus_intersection)\
+        task -> node = lagus_##T##_##E##_join_nodes (buffer, left.node, left.height, node, right.node, right.height, & task -> height);\
+    else {\
+        buffer [node].size = 0;\
+        task -> node = lagus_##T##_##E##_join_pair (buffer, left.node, left.height, right.node, right.height, & task -> height);\
+    }\
+    return NULL;\
+}\
+\
+static uint64_t lagus_##T##_##E##_merge_set (lagus_##T##_##E * bst, E * first, uint64_t first_size, E * second, uint64_t second_size, E * output, uint8_t operation) {\
+    uint64_t size = 0;\
+    while (first_size && second_size) {\
+        int64_t comparison = lagus_##T##_##E##_compare (bst -> compare, * first, * second);\
+        if (comparison < 0) {\
+            if (operation != lagus_intersection) {\
+                output [size] = * first;\
+                size ++;\
+            }\
+            first ++;\
+            first_size --;\
+        } else if (comparison > 0) {\
+            if (operation == lagus_union) {\
+                output [size] = * second;\
+                size ++;\
             }\
+            second ++;\
+            second_size --;\
         } else {\
-            if (direction == lagus_left) {\
-                child = bst -> buffer [node].right_child;\
-                if (bst -> buffer [child].configuration == 0b10) {\
-                    uint64_t c = child;\
-                    uint64_t b = bst -> buffer [c].left_child;\
-                    bst -> buffer [c].size -= bst -> buffer [b].size;\
-                    uint64_t X = bst -> buffer [b].right_child;\
-                    bst -> buffer [c].left_child = X;\
-                    if (X) {\
-                        bst -> buffer [X].parent = c;\
-                        bst -> buffer [c].size += bst -> buffer [X].size;\
-                        bst -> buffer [b].size -= bst -> buffer [X].size;\
-                    }\
-                    uint64_t Y = bst -> buffer [b].left_child;\
-                    bst -> buffer [b].right_child = Y;\
-                    uint64_t Z = bst -> buffer [node].left_child;\
-                    bst -> buffer [b].left_child = Z;\
-                    if (Z) {\
-                        bst -> buffer [Z].parent = b;\
-                        bst -> buffer [b].size += bst -> buffer [Z].size;\
-                    }\
-                    bst -> buffer [node].left_child = b;\
-                    bst -> buffer [b].parent = node;\
-                    E temporal = bst -> buffer [node].element;\
-                    bst -> buffer [node].element = bst -> buffer [b].element;\
-                    bst -> buffer [b].element = temporal;\
-                    if (bst -> buffer [b].configuration == 0b00) {\
-                        bst -> buffer [c].configuration = 0b00;\
-                    } else if (bst -> buffer [b].configuration == 0b01) {\
-                        bst -> buffer [c].configuration = 0b00;\
-                        bst -> buffer [b].configuration = 0b10;\
-                    } else {\
-                        bst -> buffer [c].configuration = 0b01;\
-                        bst -> buffer [b].configuration = 0b00;\
-                    }\
-                } else {\
-                    uint64_t b = child;\
-                    uint64_t c = bst -> buffer [b].right_child;\
-                    bst -> buffer [b].size -= bst -> buffer [c].size;\
-                    uint64_t Y = bst -> buffer [b].left_child;\
-                    bst -> buffer [b].right_child = Y;\
-                    uint64_t Z = bst -> buffer [node].left_child;\
-                    bst -> buffer [b].left_child = Z;\
-                    if (Z) {\
-                        bst -> buffer [Z].parent = b;\
-                        bst -> buffer [b].size += bst -> buffer [Z].size;\
-                    }\
-                    bst -> buffer [node].right_child = c;\
-                    bst -> buffer [c].parent = node;\
-                    bst -> buffer [node].left_child = b;\
-                    bst -> buffer [b].parent = node;\
-                    E temporal = bst -> buffer [node].element;\
-                    bst -> buffer [node].element = bst -> buffer [b].element;\
-                    bst -> buffer [b].element = temporal;\
-                    if (bst -> buffer [child].configuration == 0b00) {\
-                        bst -> buffer [child].configuration = 0b01;\
-                        bst -> buffer [node].configuration = 0b10;\
-                        break;\
-                    } else\
-                        bst -> buffer [child].configuration = 0b00;\
-                    \
-                }\
+            if (operation != lagus_difference) {\
+                output [size] = * first;\
+                size ++;\
             }\
+            first ++;\
+            first_size --;\
+            second ++;\
+            second_size --;\
         }\
-        bst -> buffer [node].configuration = 0b00;\
-        if (node == lagus_root) {\
-            bst -> height --;\
-            return lagus_success;\
+    }\
+    if (operation != lagus_intersection)\
+        while (first_size) {\
+            output [size] = * first;\
+            size ++;\
+            first ++;\
+            first_size --;\
         }\
-        child = node;\
-        node = bst -> buffer [node].parent;\
-        if (bst -> buffer [node].left_child == child)\
-            direction = lagus_left;\
-        else\
-            direction = lagus_right;\
+    if (operation == lagus_union)\
+        while (second_size) {\
+            output [size] = * second;\
+            size ++;\
+            second ++;\
+            second_size --;\
+        }\
+    return size;\
+}\
+\
+static lagus_result lagus_##T##_##E##_combine (lagus_##T##_##E * bst, lagus_##T##_##E * other, lagus_##T##_##E * result, uint64_t threads, uint8_t operation) {\
+    result -> modifications ++;\
+    uint64_t first_size = 0;\
+    uint64_t second_size = 0;\
+    if (bst -> height)\
+        first_size = bst -> buffer [lagus_root].size;\
+    if (other -> height)\
+        second_size = other -> buffer [lagus_root].size;\
+    uint64_t total = first_size + second_size;\
+    uint64_t capacity = total;\
+    if (! capacity)\
+        capacity = 1;\
+    lagus_##T##_node_##E * buffer = result -> memory_management.allocate (_Alignof (lagus_##T##_node_##E), capacity * sizeof (lagus_##T##_node_##E));\
+    if (! buffer)\
+        return lagus_memory_allocation;\
+    buffer --;\
+    uint64_t small = first_size;\
+    uint64_t large = second_size;\
+    if (small > large) {\
+        small = second_size;\
+        large = first_size;\
+    }\
+    uint64_t size, height;\
+    if (small && small * lagus_##T##_##E##_balanced_height (large / small) * 4 >= large) {\
+        E * scratch = result -> memory_management.allocate (_Alignof (E), (total << 1) * sizeof (E));\
+        if (! scratch) {\
+            result -> memory_management.deallocate (buffer + 1);\
+            return lagus_memory_allocation;\
+        }\
+        lagus_##T##_##E##_flatten (bst -> buffer, lagus_root, scratch);\
+        lagus_##T##_##E##_flatten (other -> buffer, lagus_root, scratch + first_size);\
+        size = lagus_##T##_##E##_merge_set (bst, scratch, first_size, scratch + first_size, second_size, scratch + total, operation);\
+        if (size)\
+            lagus_##T##_##E##_build_subtree (buffer, scratch + total, size, lagus_root, lagus_none);\
+        height = lagus_##T##_##E##_balanced_height (size);\
+        result -> memory_management.deallocate (scratch);\
+    } else {\
+        for (uint64_t index = 1; index <= first_size; index ++)\
+            buffer [index] = bst -> buffer [index];\
+        for (uint64_t index = 1; index <= second_size; index ++) {\
+            lagus_##T##_node_##E node = other -> buffer [index];\
+            if (node.parent)\
+                node.parent += first_size;\
+            if (node.left_child)\
+                node.left_child += first_size;\
+            if (node.right_child)\
+                node.right_child += first_size;\
+            buffer [first_size + index] = node;\
+        }\
+        lagus_##T##_combination_##E task = {\
+            .bst = bst,\
+            .buffer = buffer,\
+            .operation = operation\
+        };\
+        if (first_size) {\
+            task.first = lagus_root;\
+            task.first_height = bst -> height;\
+        }\
+        if (second_size) {\
+            task.second = first_size + lagus_root;\
+            task.second_height = other -> height;\
+        }\
+        while (lagus_one << task.depth < threads)\
+            task.depth ++;\
+        lagus_##T##_##E##_combine_task (& task);\
+        size = 0;\
+        if (task.node) {\
+            size = buffer [task.node].size;\
+            buffer [task.node].parent = lagus_none;\
+            lagus_##T##_##E##_compact (buffer, task.node, total, size);\
+        }\
+        height = task.height;\
+    }\
+    result -> memory_management.deallocate (result -> buffer + 1);\
+    result -> buffer = buffer;\
+    result -> capacity = capacity;\
+    result -> height = height;\
+    if (size == 0)\
+        buffer [lagus_root] = (lagus_##T##_node_##E) {\
+            .parent = lagus_none,\
+            .left_child = lagus_none,\
+            .right_child = lagus_none,\
+            .size = 0\
+        };\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_##E##_union (lagus_##T##_##E * bst, lagus_##T##_##E * other, lagus_##T##_##E * result, uint64_t threads) {\
+    return lagus_##T##_##E##_combine (bst, other, result, threads, lagus_union);\
+}\
+\
+lagus_result lagus_##T##_##E##_intersection (lagus_##T##_##E * bst, lagus_##T##_##E * other, lagus_##T##_##E * result, uint64_t threads) {\
+    return lagus_##T##_##E##_combine (bst, other, result, threads, lagus_intersection);\
+}\
+\
+lagus_result lagus_##T##_##E##_difference (lagus_##T##_##E * bst, lagus_##T##_##E * other, lagus_##T##_##E * result, uint64_t threads) {\
+    return lagus_##T##_##E##_combine (bst, other, result, threads, lagus_difference);\
+}\
+\
+lagus_result lagus_##T##_##E##_relayout_step (lagus_##T##_##E * bst, lagus_##T##_relayout_cursor_##E * cursor, uint64_t steps) {\
+    uint64_t size = bst -> buffer [lagus_root].size;\
+    if (bst -> height == 0)\
+        size = 0;\
+    uint64_t position = cursor -> position;\
+    if (cursor -> modifications != bst -> modifications) {\
+        cursor -> modifications = bst -> modifications;\
+        position = 0;\
+    }\
+    if (position == 0 && size)\
+        position = lagus_root;\
+    while (steps && position < size) {\
+        uint64_t node = position;\
+        uint64_t next = bst -> buffer [node].left_child;\
+        if (! next)\
+            next = bst -> buffer [node].right_child;\
+        while (! next && node != lagus_root) {\
+            uint64_t parent = bst -> buffer [node].parent;\
+            if (bst -> buffer [parent].left_child == node)\
+                next = bst -> buffer [parent].right_child;\
+            node = parent;\
+        }\
+        if (! next) {\
+            position = size;\
+            break;\
+        }\
+        position ++;\
+        if (next != position)\
+            lagus_##T##_##E##_swap_nodes (bst -> buffer, position, next);\
+        steps --;\
+    }\
+    cursor -> position = position;\
+    if (position < size)\
+        return lagus_success;\
+    return lagus_stop;\
+}\
+\
+lagus_result lagus_##T##_##E##_relayout (lagus_##T##_##E * bst) {\
+    lagus_##T##_relayout_cursor_##E cursor = {\
+        .position = 0,\
+        .modifications = bst -> modifications\
+    };\
+    lagus_##T##_##E##_relayout_step (bst, & cursor, UINT64_MAX);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_iterator_##E##_initialize (lagus_##T##_iterator_##E * iterator, lagus_##T##_##E * bst) {\
+    if (bst -> height) {\
+        * iterator = (lagus_##T##_iterator_##E) {\
+            .height = bst -> height,\
+            .node = lagus_root,\
+            .buffer = bst -> buffer\
+        };\
+        while (true) {\
+            uint64_t child = bst -> buffer [iterator -> node].left_child;\
+            if (! child)\
+                break;\
+            iterator -> height --;\
+            iterator -> node = child;\
+        }\
+        iterator -> index = lagus_one << iterator -> height - 1;\
+    } else\
+        iterator -> node = lagus_none;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_iterator_##E##_next (lagus_##T##_iterator_##E * iterator, E * element) {\
+    if (! iterator -> node)\
+        return lagus_stop;\
+    * element = iterator -> buffer [iterator -> node].element;\
+    uint64_t child = iterator -> buffer [iterator -> node].right_child;\
+    if (child) {\
+        iterator -> height --;\
+        iterator -> index += lagus_one << iterator -> height - 1;\
+        while (true) {\
+            iterator -> node = child;\
+            child = iterator -> buffer [iterator -> node].left_child;\
+            if (! child)\
+                break;\
+            iterator -> height --;\
+            iterator -> index -= lagus_one << iterator -> height - 1;\
+        }\
+    } else {\
+        iterator -> index += lagus_one << iterator -> height - 1;\
+        __uint128_t index = iterator -> index;\
+        uint64_t height = 1;\
+        if (! (index & 0xFFFFFFFFFFFFFFFF)) {\
+            index >>= 64;\
+            height += 64;\
+        }\
+        if (! (index & 0x00000000FFFFFFFF)) {\
+            index >>= 32;\
+            height += 32;\
+        }\
+        if (! (index & 0x000000000000FFFF)) {\
+            index >>= 16;\
+            height += 16;\
+        }\
+        if (! (index & 0x00000000000000FF)) {\
+            index >>= 8;\
+            height += 8;\
+        }\
+        if (! (index & 0x0000000000000000F)) {\
+            index >>= 4;\
+            height += 4;\
+        }\
+        if (! (index & 0x00000000000000003)) {\
+            index >>= 2;\
+            height += 2;\
+        }\
+        if (! (index & 0x00000000000000001))\
+            height += 1;\
+        \
+        while (true) {\
+            iterator -> height ++;\
+            iterator -> node = iterator -> buffer [iterator -> node].parent;\
+            if (iterator -> height == height)\
+                break;\
+        }\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_iterator_##E##_finalize (lagus_##T##_iterator_##E * iterator) {\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_range_iterator_##E##_initialize (lagus_##T##_range_iterator_##E * iterator, lagus_##T##_##E * bst, E * lower, E * upper) {\
+    iterator -> bst = bst;\
+    iterator -> bounded = upper != NULL;\
+    if (upper)\
+        iterator -> upper = * upper;\
+    iterator -> iterator = (lagus_##T##_iterator_##E) {\
+        .node = lagus_none,\
+        .buffer = bst -> buffer\
+    };\
+    if (bst -> height == 0)\
+        return lagus_success;\
+    uint64_t height = bst -> height;\
+    __uint128_t index = lagus_one << height - 1;\
+    uint64_t node = lagus_root;\
+    while (true) {\
+        uint64_t child;\
+        if (! lower || lagus_##T##_##E##_compare (bst -> compare, * lower, bst -> buffer [node].element) <= 0) {\
+            iterator -> iterator.node = node;\
+            iterator -> iterator.height = height;\
+            iterator -> iterator.index = index;\
+            child = bst -> buffer [node].left_child;\
+            if (! child)\
+                break;\
+            height --;\
+            index -= lagus_one << height - 1;\
+        } else {\
+            child = bst -> buffer [node].right_child;\
+            if (! child)\
+                break;\
+            height --;\
+            index += lagus_one << height - 1;\
+        }\
+        node = child;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_##T##_range_iterator_##E##_next (lagus_##T##_range_iterator_##E * iterator, E * element) {\
+    lagus_##T##_##E * bst = iterator -> bst;\
+    uint64_t node = iterator -> iterator.node;\
+    if (! node)\
+        return lagus_stop;\
+    if (iterator -> bounded && lagus_##T##_##E##_compare (bst -> compare, bst -> buffer [node].element, iterator -> upper) >= 0) {\
+        iterator -> iterator.node = lagus_none;\
+        return lagus_stop;\
+    }\
+    return lagus_##T##_iterator_##E##_next (& iterator -> iterator, element);\
+}\
+\
+lagus_result lagus_##T##_range_iterator_##E##_finalize (lagus_##T##_range_iterator_##E * iterator) {\
+    return lagus_success;\
+}\
+\
+static void lagus_##T##_##E##_fill (E * buffer, uint64_t size, uint64_t node, lagus_##T##_iterator_##E * iterator) {\
+    while (node <= size) {\
+        lagus_##T##_##E##_fill (buffer, size, node << 1, iterator);\
+        lagus_##T##_iterator_##E##_next (iterator, buffer + node);\
+        node = node << 1 | 1;\
+    }\
+}\
+\
+lagus_result lagus_##T##_##E##_freeze (lagus_##T##_##E * bst, lagus_frozen_##T##_##E * frozen) {\
+    uint64_t size = bst -> buffer [lagus_root].size;\
+    if (bst -> height == 0)\
+        size = 0;\
+    uint64_t alignment = _Alignof (E);\
+    if (alignment < 64)\
+        alignment = 64;\
+    uint64_t bytes = (size + 1) * sizeof (E) + alignment - 1 & ~ (alignment - 1);\
+    E * buffer = bst -> memory_management.allocate (alignment, bytes);\
+    if (! buffer)\
+        return lagus_memory_allocation;\
+    * frozen = (lagus_frozen_##T##_##E) {\
+        .size = size,\
+        .buffer = buffer,\
+        .compare = bst -> compare,\
+        .memory_management = bst -> memory_management\
+    };\
+    lagus_##T##_iterator_##E iterator;\
+    lagus_##T##_iterator_##E##_initialize (& iterator, bst);\
+    lagus_##T##_##E##_fill (buffer, size, lagus_root, & iterator);\
+    lagus_##T##_iterator_##E##_finalize (& iterator);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_frozen_##T##_##E##_finalize (lagus_frozen_##T##_##E * frozen) {\
+    frozen -> memory_management.deallocate (frozen -> buffer);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_frozen_##T##_##E##_size (lagus_frozen_##T##_##E * frozen, uint64_t * size) {\
+    * size = frozen -> size;\
+    return lagus_success;\
+}\
+\
+static uint64_t lagus_frozen_##T##_##E##_subtree_size (uint64_t size, uint64_t node) {\
+    if (node > size)\
+        return 0;\
+    uint64_t height = __builtin_clzll (node) - __builtin_clzll (size);\
+    uint64_t start = node << height;\
+    uint64_t last = 0;\
+    if (start <= size)\
+        last = size - start + 1;\
+    if (last > 1ull << height)\
+        last = 1ull << height;\
+    return (1ull << height) - 1 + last;\
+}\
+\
+static uint64_t lagus_frozen_##T##_##E##_rank (uint64_t size, uint64_t node) {\
+    uint64_t rank = lagus_frozen_##T##_##E##_subtree_size (size, node << 1) + 1;\
+    while (node > lagus_root) {\
+        if (node & 1)\
+            rank += lagus_frozen_##T##_##E##_subtree_size (size, node - 1) + 1;\
+        node >>= 1;\
+    }\
+    return rank;\
+}\
+\
+static uint64_t lagus_frozen_##T##_##E##_bound (lagus_frozen_##T##_##E * frozen, E * element, bool inclusive) {\
+    E * buffer = frozen -> buffer;\
+    uint64_t size = frozen -> size;\
+    uint64_t node = lagus_root;\
+    if (inclusive)\
+        while (node <= size) {\
+            __builtin_prefetch (buffer + (node << 4));\
+            node = node << 1 | lagus_##T##_##E##_compare (frozen -> compare, buffer [node], * element) <= 0;\
+        }\
+    else\
+        while (node <= size) {\
+            __builtin_prefetch (buffer + (node << 4));\
+            node = node << 1 | lagus_##T##_##E##_compare (frozen -> compare, buffer [node], * element) < 0;\
+        }\
+    node >>= __builtin_ctzll (~ node) + 1;\
+    if (! node)\
+        return size;\
+    return lagus_frozen_##T##_##E##_rank (size, node) - 1;\
+}\
+\
+static uint64_t lagus_frozen_##T##_##E##_select (lagus_frozen_##T##_##E * frozen, uint64_t index) {\
+    uint64_t node = lagus_root;\
+    while (true) {\
+        uint64_t size = lagus_frozen_##T##_##E##_subtree_size (frozen -> size, node << 1);\
+        if (index == size + 1)\
+            return node;\
+        if (index <= size)\
+            node <<= 1;\
+        else {\
+            index -= size + 1;\
+            node = node << 1 | 1;\
+        }\
+    }\
+}\
+\
+lagus_result lagus_frozen_##T##_##E##_search_left (lagus_frozen_##T##_##E * frozen, E * element, uint64_t * index) {\
+    uint64_t rank = lagus_frozen_##T##_##E##_bound (frozen, element, false);\
+    if (rank == frozen -> size)\
+        return lagus_not_contained;\
+    E * match = frozen -> buffer + lagus_frozen_##T##_##E##_select (frozen, rank + 1);\
+    if (lagus_##T##_##E##_compare (frozen -> compare, * element, * match))\
+        return lagus_not_contained;\
+    * element = * match;\
+    * index = rank + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_frozen_##T##_##E##_search_right (lagus_frozen_##T##_##E * frozen, E * element, uint64_t * index) {\
+    uint64_t rank = lagus_frozen_##T##_##E##_bound (frozen, element, true);\
+    if (rank == 0)\
+        return lagus_not_contained;\
+    E * match = frozen -> buffer + lagus_frozen_##T##_##E##_select (frozen, rank);\
+    if (lagus_##T##_##E##_compare (frozen -> compare, * element, * match))\
+        return lagus_not_contained;\
+    * element = * match;\
+    * index = rank;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_frozen_##T##_##E##_rank_left (lagus_frozen_##T##_##E * frozen, E * element, uint64_t * index) {\
+    * index = lagus_frozen_##T##_##E##_bound (frozen, element, false) + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_frozen_##T##_##E##_rank_right (lagus_frozen_##T##_##E * frozen, E * element, uint64_t * index) {\
+    * index = lagus_frozen_##T##_##E##_bound (frozen, element, true) + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_frozen_##T##_##E##_get_at (lagus_frozen_##T##_##E * frozen, uint64_t index, E * element) {\
+    * element = frozen -> buffer [lagus_frozen_##T##_##E##_select (frozen, index)];\
+    return lagus_success;\
+}
+
+
+# define lagus_implement_bst(E) lagus_implement_bst_inline(E, compare)
+
+# define lagus_implement_bst_inline(E, C) \
+\
+int64_t lagus_binary_compare_##E (E a, E b) {\
+    return lagus_binary_compare ((uint8_t *) & a, (uint8_t *) & b, sizeof (E));\
+}\
+\
+lagus_implement_bst_named(E, bst, C, lagus_binary_compare_##E, lagus_bst_no_update)\
+\
+lagus_result lagus_bst_##E##_set_at (lagus_bst_##E * bst, uint64_t index, E * element) {\
+    uint64_t node = lagus_root;\
+    while (true) {\
+        uint64_t left_child = bst -> buffer [node].left_child;\
+        uint64_t size;\
+        if (left_child)\
+            size = bst -> buffer [left_child].size;\
+        else\
+            size = 0;\
+        if (index == size + 1) {\
+            E temporal = bst -> buffer [node].element;\
+            bst -> buffer [node].element = * element;\
+            * element = temporal;\
+            return lagus_success;\
+        }\
+        if (index <= size)\
+            node = left_child;\
+        else {\
+            index -= size + 1;\
+            node = bst -> buffer [node].right_child;\
+        }\
+    }\
+}
+/* Prefixed keys */
+
+// Declaration
+
+# define lagus_declare_prefixed(E) \
+\
+typedef struct lagus_prefixed_##E {\
+    uint64_t prefix;\
+    E element;\
+} lagus_prefixed_##E;\
+\
+lagus_prefixed_##E lagus_prefixed_##E##_make (E element);\
+\
+int64_t lagus_prefixed_##E##_compare (lagus_prefixed_##E a, lagus_prefixed_##E b);
+
+// Implementation
+
+# define lagus_implement_prefixed(E, P, C) \
+\
+lagus_prefixed_##E lagus_prefixed_##E##_make (E element) {\
+    return (lagus_prefixed_##E) {\
+        .prefix = P (element),\
+        .element = element\
+    };\
+}\
+\
+int64_t lagus_prefixed_##E##_compare (lagus_prefixed_##E a, lagus_prefixed_##E b) {\
+    if (a.prefix < b.prefix)\
+        return -1;\
+    if (a.prefix > b.prefix)\
+        return 1;\
+    return C (a.element, b.element);\
+}
+
+/* Concurrent BST */
+
+# define lagus_concurrent_bst_header 64
+# define lagus_concurrent_bst_steps 128
+
+// Declaration
+
+# define lagus_declare_concurrent_bst(E) \
+\
+typedef struct lagus_concurrent_bst_slot_##E {\
+    _Alignas (64) _Atomic uint64_t epoch;\
+} lagus_concurrent_bst_slot_##E;\
+\
+typedef struct lagus_concurrent_bst_retired_##E {\
+    void * block;\
+    uint64_t epoch;\
+} lagus_concurrent_bst_retired_##E;\
+\
+typedef struct lagus_concurrent_bst_##E {\
+    lagus_bst_##E bst;\
+    lagus_bst_node_##E * _Atomic buffer;\
+    _Atomic uint64_t version;\
+    _Atomic uint64_t epoch;\
+    uint64_t readers;\
+    lagus_concurrent_bst_slot_##E * slots;\
+    uint64_t retired_size;\
+    uint64_t retired_capacity;\
+    lagus_concurrent_bst_retired_##E * retired;\
+    lagus_memory_management memory_management;\
+} lagus_concurrent_bst_##E;\
+\
+typedef struct lagus_concurrent_bst_iterator_##E {\
+    lagus_concurrent_bst_##E * tree;\
+    uint64_t reader;\
+    uint64_t index;\
+    uint64_t node;\
+    uint64_t version;\
+} lagus_concurrent_bst_iterator_##E;\
+\
+lagus_result lagus_concurrent_bst_##E##_initialize (lagus_concurrent_bst_##E * tree, uint64_t readers);\
+\
+lagus_result lagus_concurrent_bst_##E##_custom_initialize (lagus_concurrent_bst_##E * tree, uint64_t readers, lagus_compare_##E compare, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_concurrent_bst_##E##_finalize (lagus_concurrent_bst_##E * tree);\
+\
+lagus_result lagus_concurrent_bst_##E##_add_left (lagus_concurrent_bst_##E * tree, E element);\
+\
+lagus_result lagus_concurrent_bst_##E##_add_right (lagus_concurrent_bst_##E * tree, E element);\
+\
+lagus_result lagus_concurrent_bst_##E##_add_at (lagus_concurrent_bst_##E * tree, uint64_t index, E element);\
+\
+lagus_result lagus_concurrent_bst_##E##_remove_left (lagus_concurrent_bst_##E * tree, E * element);\
+\
+lagus_result lagus_concurrent_bst_##E##_remove_right (lagus_concurrent_bst_##E * tree, E * element);\
+\
+lagus_result lagus_concurrent_bst_##E##_remove_at (lagus_concurrent_bst_##E * tree, uint64_t index, E * element);\
+\
+lagus_result lagus_concurrent_bst_##E##_set_at (lagus_concurrent_bst_##E * tree, uint64_t index, E * element);\
+\
+lagus_result lagus_concurrent_bst_##E##_size (lagus_concurrent_bst_##E * tree, uint64_t reader, uint64_t * size);\
+\
+lagus_result lagus_concurrent_bst_##E##_search_left (lagus_concurrent_bst_##E * tree, uint64_t reader, E * element, uint64_t * index);\
+\
+lagus_result lagus_concurrent_bst_##E##_get_at (lagus_concurrent_bst_##E * tree, uint64_t reader, uint64_t index, E * element);\
+\
+lagus_result lagus_concurrent_bst_iterator_##E##_initialize (lagus_concurrent_bst_iterator_##E * iterator, lagus_concurrent_bst_##E * tree, uint64_t reader);\
+\
+lagus_result lagus_concurrent_bst_iterator_##E##_next (lagus_concurrent_bst_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_concurrent_bst_iterator_##E##_finalize (lagus_concurrent_bst_iterator_##E * iterator);
+
+// Implementation
+
+# define lagus_implement_concurrent_bst(E) \
+\
+static _Thread_local lagus_concurrent_bst_##E * lagus_concurrent_bst_##E##_writer;\
+\
+static void * lagus_concurrent_bst_##E##_allocate (uint64_t alignment, uint64_t bytes) {\
+    lagus_concurrent_bst_##E * tree = lagus_concurrent_bst_##E##_writer;\
+    uint64_t total = lagus_concurrent_bst_header + bytes + lagus_concurrent_bst_header - 1 & ~ (uint64_t) (lagus_concurrent_bst_header - 1);\
+    uint8_t * block = tree -> memory_management.allocate (lagus_concurrent_bst_header, total);\
+    if (! block)\
+        return NULL;\
+    * (uint64_t *) block = bytes;\
+    return block + lagus_concurrent_bst_header;\
+}\
+\
+static void * lagus_concurrent_bst_##E##_reallocate (void * pointer, uint64_t bytes) {\
+    lagus_concurrent_bst_##E * tree = lagus_concurrent_bst_##E##_writer;\
+    if (tree -> retired_size == tree -> retired_capacity) {\
+        uint64_t capacity = tree -> retired_capacity ? tree -> retired_capacity << 1 : 4;\
+        lagus_concurrent_bst_retired_##E * retired = tree -> memory_management.reallocate (tree -> retired, capacity * sizeof (lagus_concurrent_bst_retired_##E));\
+        if (! retired)\
+            return NULL;\
+        tree -> retired_capacity = capacity;\
+        tree -> retired = retired;\
+    }\
+    uint8_t * block = (uint8_t *) pointer - lagus_concurrent_bst_header;\
+    uint64_t size = * (uint64_t *) block;\
+    uint8_t * result = lagus_concurrent_bst_##E##_allocate (_Alignof (lagus_bst_node_##E), bytes);\
+    if (! result)\
+        return NULL;\
+    __builtin_memcpy (result, pointer, size < bytes ? size : bytes);\
+    tree -> retired [tree -> retired_size] = (lagus_concurrent_bst_retired_##E) {\
+        .block = block,\
+        .epoch = 0\
+    };\
+    tree -> retired_size ++;\
+    return result;\
+}\
+\
+static void lagus_concurrent_bst_##E##_deallocate (void * pointer) {\
+    lagus_concurrent_bst_##E * tree = lagus_concurrent_bst_##E##_writer;\
+    tree -> memory_management.deallocate ((uint8_t *) pointer - lagus_concurrent_bst_header);\
+}\
+\
+static void lagus_concurrent_bst_##E##_begin_write (lagus_concurrent_bst_##E * tree) {\
+    lagus_concurrent_bst_##E##_writer = tree;\
+    uint64_t version = atomic_load_explicit (& tree -> version, memory_order_relaxed);\
+    atomic_store_explicit (& tree -> version, version + 1, memory_order_relaxed);\
+    atomic_thread_fence (memory_order_release);\
+}\
+\
+static lagus_result lagus_concurrent_bst_##E##_end_write (lagus_concurrent_bst_##E * tree, lagus_result result) {\
+    lagus_bst_node_##E * buffer = tree -> bst.buffer;\
+    if (buffer != atomic_load_explicit (& tree -> buffer, memory_order_relaxed)) {\
+        atomic_store (& tree -> buffer, buffer);\
+        uint64_t epoch = atomic_fetch_add (& tree -> epoch, 1) + 1;\
+        for (uint64_t index = 0; index < tree -> retired_size; index ++)\
+            if (! tree -> retired [index].epoch)\
+                tree -> retired [index].epoch = epoch;\
+    }\
+    uint64_t version = atomic_load_explicit (& tree -> version, memory_order_relaxed);\
+    atomic_store_explicit (& tree -> version, version + 1, memory_order_release);\
+    if (tree -> retired_size) {\
+        uint64_t minimum = UINT64_MAX;\
+        for (uint64_t reader = 0; reader < tree -> readers; reader ++) {\
+            uint64_t epoch = atomic_load (& tree -> slots [reader].epoch);\
+            if (epoch && epoch < minimum)\
+                minimum = epoch;\
+        }\
+        uint64_t kept = 0;\
+        for (uint64_t index = 0; index < tree -> retired_size; index ++) {\
+            if (tree -> retired [index].epoch <= minimum)\
+                tree -> memory_management.deallocate (tree -> retired [index].block);\
+            else {\
+                tree -> retired [kept] = tree -> retired [index];\
+                kept ++;\
+            }\
+        }\
+        tree -> retired_size = kept;\
+    }\
+    return result;\
+}\
+\
+static void lagus_concurrent_bst_##E##_enter (lagus_concurrent_bst_##E * tree, uint64_t reader) {\
+    uint64_t epoch = atomic_load (& tree -> epoch);\
+    while (true) {\
+        atomic_store (& tree -> slots [reader].epoch, epoch);\
+        uint64_t current = atomic_load (& tree -> epoch);\
+        if (current == epoch)\
+            break;\
+        epoch = current;\
+    }\
+}\
+\
+static void lagus_concurrent_bst_##E##_leave (lagus_concurrent_bst_##E * tree, uint64_t reader) {\
+    atomic_store_explicit (& tree -> slots [reader].epoch, 0, memory_order_release);\
+}\
+\
+static uint64_t lagus_concurrent_bst_##E##_begin_read (lagus_concurrent_bst_##E * tree) {\
+    while (true) {\
+        uint64_t version = atomic_load_explicit (& tree -> version, memory_order_acquire);\
+        if (! (version & 1))\
+            return version;\
+    }\
+}\
+\
+static bool lagus_concurrent_bst_##E##_validate (lagus_concurrent_bst_##E * tree, uint64_t version) {\
+    atomic_thread_fence (memory_order_acquire);\
+    return atomic_load_explicit (& tree -> version, memory_order_relaxed) == version;\
+}\
+\
+static uint64_t lagus_concurrent_bst_##E##_capacity (lagus_bst_node_##E * buffer) {\
+    return * (uint64_t *) ((uint8_t *) (buffer + 1) - lagus_concurrent_bst_header) / sizeof (lagus_bst_node_##E);\
+}\
+\
+static uint64_t lagus_concurrent_bst_##E##_locate (lagus_bst_node_##E * buffer, uint64_t capacity, uint64_t index) {\
+    uint64_t node = lagus_root;\
+    for (uint64_t step = 0; step < lagus_concurrent_bst_steps; step ++) {\
+        if (! node || node > capacity)\
+            return lagus_none;\
+        uint64_t left_child = buffer [node].left_child;\
+        uint64_t size;\
+        if (left_child && left_child <= capacity)\
+            size = buffer [left_child].size;\
+        else\
+            size = 0;\
+        if (index == size + 1)\
+            return node;\
+        if (index <= size)\
+            node = left_child;\
+        else {\
+            index -= size + 1;\
+            node = buffer [node].right_child;\
+        }\
+    }\
+    return lagus_none;\
+}\
+\
+static uint64_t lagus_concurrent_bst_##E##_successor (lagus_bst_node_##E * buffer, uint64_t capacity, uint64_t node) {\
+    uint64_t child = buffer [node].right_child;\
+    if (child) {\
+        for (uint64_t step = 0; step < lagus_concurrent_bst_steps; step ++) {\
+            if (child > capacity)\
+                return lagus_none;\
+            node = child;\
+            child = buffer [node].left_child;\
+            if (! child)\
+                return node;\
+        }\
+        return lagus_none;\
+    }\
+    for (uint64_t step = 0; step < lagus_concurrent_bst_steps; step ++) {\
+        uint64_t parent = buffer [node].parent;\
+        if (! parent || parent > capacity)\
+            return lagus_none;\
+        if (buffer [parent].left_child == node)\
+            return parent;\
+        node = parent;\
+    }\
+    return lagus_none;\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_initialize (lagus_concurrent_bst_##E * tree, uint64_t readers) {\
+    return lagus_concurrent_bst_##E##_custom_initialize (tree, readers, NULL, NULL);\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_custom_initialize (lagus_concurrent_bst_##E * tree, uint64_t readers, lagus_compare_##E compare, lagus_memory_management * memory_management) {\
+    if (memory_management)\
+        tree -> memory_management = * memory_management;\
+    else\
+        tree -> memory_management = (lagus_memory_management) {\
+            .allocate = aligned_alloc,\
+            .reallocate = realloc,\
+            .deallocate = free\
+        };\
+    if (! readers)\
+        readers = 1;\
+    tree -> slots = tree -> memory_management.allocate (_Alignof (lagus_concurrent_bst_slot_##E), readers * sizeof (lagus_concurrent_bst_slot_##E));\
+    if (! tree -> slots)\
+        return lagus_memory_allocation;\
+    for (uint64_t reader = 0; reader < readers; reader ++)\
+        atomic_init (& tree -> slots [reader].epoch, 0);\
+    tree -> readers = readers;\
+    tree -> retired_size = 0;\
+    tree -> retired_capacity = 0;\
+    tree -> retired = NULL;\
+    lagus_memory_management hooks = {\
+        .allocate = lagus_concurrent_bst_##E##_allocate,\
+        .reallocate = lagus_concurrent_bst_##E##_reallocate,\
+        .deallocate = lagus_concurrent_bst_##E##_deallocate\
+    };\
+    lagus_concurrent_bst_##E##_writer = tree;\
+    if (lagus_bst_##E##_custom_initialize (& tree -> bst, 1, compare, & hooks)) {\
+        tree -> memory_management.deallocate (tree -> slots);\
+        return lagus_memory_allocation;\
+    }\
+    atomic_init (& tree -> buffer, tree -> bst.buffer);\
+    atomic_init (& tree -> version, 0);\
+    atomic_init (& tree -> epoch, 1);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_finalize (lagus_concurrent_bst_##E * tree) {\
+    lagus_concurrent_bst_##E##_writer = tree;\
+    lagus_bst_##E##_finalize (& tree -> bst);\
+    for (uint64_t index = 0; index < tree -> retired_size; index ++)\
+        tree -> memory_management.deallocate (tree -> retired [index].block);\
+    if (tree -> retired)\
+        tree -> memory_management.deallocate (tree -> retired);\
+    tree -> memory_management.deallocate (tree -> slots);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_add_left (lagus_concurrent_bst_##E * tree, E element) {\
+    lagus_concurrent_bst_##E##_begin_write (tree);\
+    return lagus_concurrent_bst_##E##_end_write (tree, lagus_bst_##E##_add_left (& tree -> bst, element));\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_add_right (lagus_concurrent_bst_##E * tree, E element) {\
+    lagus_concurrent_bst_##E##_begin_write (tree);\
+    return lagus_concurrent_bst_##E##_end_write (tree, lagus_bst_##E##_add_right (& tree -> bst, element));\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_add_at (lagus_concurrent_bst_##E * tree, uint64_t index, E element) {\
+    lagus_concurrent_bst_##E##_begin_write (tree);\
+    return lagus_concurrent_bst_##E##_end_write (tree, lagus_bst_##E##_add_at (& tree -> bst, index, element));\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_remove_left (lagus_concurrent_bst_##E * tree, E * element) {\
+    lagus_concurrent_bst_##E##_begin_write (tree);\
+    return lagus_concurrent_bst_##E##_end_write (tree, lagus_bst_##E##_remove_left (& tree -> bst, element));\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_remove_right (lagus_concurrent_bst_##E * tree, E * element) {\
+    lagus_concurrent_bst_##E##_begin_write (tree);\
+    return lagus_concurrent_bst_##E##_end_write (tree, lagus_bst_##E##_remove_right (& tree -> bst, element));\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_remove_at (lagus_concurrent_bst_##E * tree, uint64_t index, E * element) {\
+    lagus_concurrent_bst_##E##_begin_write (tree);\
+    return lagus_concurrent_bst_##E##_end_write (tree, lagus_bst_##E##_remove_at (& tree -> bst, index, element));\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_set_at (lagus_concurrent_bst_##E * tree, uint64_t index, E * element) {\
+    lagus_concurrent_bst_##E##_begin_write (tree);\
+    return lagus_concurrent_bst_##E##_end_write (tree, lagus_bst_##E##_set_at (& tree -> bst, index, element));\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_size (lagus_concurrent_bst_##E * tree, uint64_t reader, uint64_t * size) {\
+    lagus_concurrent_bst_##E##_enter (tree, reader);\
+    while (true) {\
+        uint64_t version = lagus_concurrent_bst_##E##_begin_read (tree);\
+        lagus_bst_node_##E * buffer = atomic_load (& tree -> buffer);\
+        uint64_t value = buffer [lagus_root].size;\
+        if (lagus_concurrent_bst_##E##_validate (tree, version)) {\
+            * size = value;\
+            break;\
+        }\
+    }\
+    lagus_concurrent_bst_##E##_leave (tree, reader);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_search_left (lagus_concurrent_bst_##E * tree, uint64_t reader, E * element, uint64_t * index) {\
+    lagus_concurrent_bst_##E##_enter (tree, reader);\
+    lagus_result result;\
+    while (true) {\
+        uint64_t version = lagus_concurrent_bst_##E##_begin_read (tree);\
+        lagus_bst_node_##E * buffer = atomic_load (& tree -> buffer);\
+        uint64_t capacity = lagus_concurrent_bst_##E##_capacity (buffer);\
+        uint64_t offset = 0;\
+        uint64_t position = 0;\
+        uint64_t match = lagus_none;\
+        uint64_t node = buffer [lagus_root].size ? lagus_root : lagus_none;\
+        for (uint64_t step = 0; node && node <= capacity && step < lagus_concurrent_bst_steps; step ++) {\
+            int64_t comparison = lagus_bst_##E##_compare (tree -> bst.compare, * element, buffer [node].element);\
+            uint64_t left_child = buffer [node].left_child;\
+            uint64_t left_size;\
+            if (left_child && left_child <= capacity)\
+                left_size = buffer [left_child].size;\
+            else\
+                left_size = 0;\
+            if (comparison == 0) {\
+                match = node;\
+                position = offset + left_size + 1;\
+            }\
+            if (comparison > 0) {\
+                offset += left_size + 1;\
+                node = buffer [node].right_child;\
+            } else\
+                node = left_child;\
+        }\
+        E value;\
+        if (match)\
+            value = buffer [match].element;\
+        if (! node && lagus_concurrent_bst_##E##_validate (tree, version)) {\
+            if (match) {\
+                * element = value;\
+                * index = position;\
+                result = lagus_success;\
+            } else\
+                result = lagus_not_contained;\
+            break;\
+        }\
+    }\
+    lagus_concurrent_bst_##E##_leave (tree, reader);\
+    return result;\
+}\
+\
+lagus_result lagus_concurrent_bst_##E##_get_at (lagus_concurrent_bst_##E * tree, uint64_t reader, uint64_t index, E * element) {\
+    lagus_concurrent_bst_##E##_enter (tree, reader);\
+    lagus_result result;\
+    while (true) {\
+        uint64_t version = lagus_concurrent_bst_##E##_begin_read (tree);\
+        lagus_bst_node_##E * buffer = atomic_load (& tree -> buffer);\
+        if (index == 0 || index > buffer [lagus_root].size) {\
+            if (lagus_concurrent_bst_##E##_validate (tree, version)) {\
+                result = lagus_not_contained;\
+                break;\
+            }\
+            continue;\
+        }\
+        uint64_t node = lagus_concurrent_bst_##E##_locate (buffer, lagus_concurrent_bst_##E##_capacity (buffer), index);\
+        if (! node)\
+            continue;\
+        E value = buffer [node].element;\
+        if (lagus_concurrent_bst_##E##_validate (tree, version)) {\
+            * element = value;\
+            result = lagus_success;\
+            break;\
+        }\
+    }\
+    lagus_concurrent_bst_##E##_leave (tree, reader);\
+    return result;\
+}\
+\
+lagus_result lagus_concurrent_bst_iterator_##E##_initialize (lagus_concurrent_bst_iterator_##E * iterator, lagus_concurrent_bst_##E * tree, uint64_t reader) {\
+    * iterator = (lagus_concurrent_bst_iterator_##E) {\
+        .tree = tree,\
+        .reader = reader,\
+        .index = 1,\
+        .node = lagus_none,\
+        .version = 1\
+    };\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_concurrent_bst_iterator_##E##_next (lagus_concurrent_bst_iterator_##E * iterator, E * element) {\
+    lagus_concurrent_bst_##E * tree = iterator -> tree;\
+    lagus_concurrent_bst_##E##_enter (tree, iterator -> reader);\
+    lagus_result result;\
+    while (true) {\
+        uint64_t version = lagus_concurrent_bst_##E##_begin_read (tree);\
+        lagus_bst_node_##E * buffer = atomic_load (& tree -> buffer);\
+        uint64_t capacity = lagus_concurrent_bst_##E##_capacity (buffer);\
+        if (iterator -> index > buffer [lagus_root].size) {\
+            if (lagus_concurrent_bst_##E##_validate (tree, version)) {\
+                result = lagus_stop;\
+                break;\
+            }\
+            continue;\
+        }\
+        uint64_t node;\
+        if (iterator -> version == version && iterator -> node)\
+            node = iterator -> node;\
+        else\
+            node = lagus_concurrent_bst_##E##_locate (buffer, capacity, iterator -> index);\
+        if (! node)\
+            continue;\
+        E value = buffer [node].element;\
+        uint64_t successor = lagus_concurrent_bst_##E##_successor (buffer, capacity, node);\
+        if (lagus_concurrent_bst_##E##_validate (tree, version)) {\
+            * element = value;\
+            iterator -> index ++;\
+            iterator -> node = successor;\
+            iterator -> version = version;\
+            result = lagus_success;\
+            break;\
+        }\
+    }\
+    lagus_concurrent_bst_##E##_leave (tree, iterator -> reader);\
+    return result;\
+}\
+\
+lagus_result lagus_concurrent_bst_iterator_##E##_finalize (lagus_concurrent_bst_iterator_##E * iterator) {\
+    return lagus_success;\
+}
+
+/* Persistent BST */
+
+# define lagus_persistent_bst_depth 96
+
+// Declaration
+
+# define lagus_declare_persistent_bst(E) \
+\
+typedef int64_t (* lagus_compare_##E) (E, E);\
+\
+typedef struct lagus_persistent_bst_node_##E {\
+    uint64_t left_child;\
+    uint64_t right_child;\
+    uint64_t size;\
+    uint64_t stamp;\
+    uint8_t height;\
+    E element;\
+} lagus_persistent_bst_node_##E;\
+\
+typedef struct lagus_persistent_bst_version_##E {\
+    uint64_t root;\
+    bool live;\
+} lagus_persistent_bst_version_##E;\
+\
+typedef struct lagus_persistent_bst_##E {\
+    uint64_t generation;\
+    uint64_t capacity;\
+    uint64_t used;\
+    uint64_t free;\
+    uint64_t free_size;\
+    lagus_persistent_bst_node_##E * buffer;\
+    uint64_t versions_capacity;\
+    uint64_t versions_size;\
+    lagus_persistent_bst_version_##E * versions;\
+    lagus_compare_##E compare;\
+    lagus_memory_management memory_management;\
+} lagus_persistent_bst_##E;\
+\
+typedef struct lagus_persistent_bst_iterator_##E {\
+    uint64_t depth;\
+    uint64_t stack [lagus_persistent_bst_depth];\
+    lagus_persistent_bst_node_##E * buffer;\
+} lagus_persistent_bst_iterator_##E;\
+\
+lagus_result lagus_persistent_bst_##E##_initialize (lagus_persistent_bst_##E * tree);\
+\
+lagus_result lagus_persistent_bst_##E##_custom_initialize (lagus_persistent_bst_##E * tree, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_persistent_bst_##E##_finalize (lagus_persistent_bst_##E * tree);\
+\
+lagus_result lagus_persistent_bst_##E##_snapshot (lagus_persistent_bst_##E * tree, uint64_t * version);\
+\
+lagus_result lagus_persistent_bst_##E##_release (lagus_persistent_bst_##E * tree, uint64_t version);\
+\
+lagus_result lagus_persistent_bst_##E##_collect (lagus_persistent_bst_##E * tree);\
+\
+lagus_result lagus_persistent_bst_##E##_size (lagus_persistent_bst_##E * tree, uint64_t version, uint64_t * size);\
+\
+lagus_result lagus_persistent_bst_##E##_add_left (lagus_persistent_bst_##E * tree, E element);\
+\
+lagus_result lagus_persistent_bst_##E##_add_right (lagus_persistent_bst_##E * tree, E element);\
+\
+lagus_result lagus_persistent_bst_##E##_search_left (lagus_persistent_bst_##E * tree, uint64_t version, E * element, uint64_t * index);\
+\
+lagus_result lagus_persistent_bst_##E##_search_right (lagus_persistent_bst_##E * tree, uint64_t version, E * element, uint64_t * index);\
+\
+lagus_result lagus_persistent_bst_##E##_remove_left (lagus_persistent_bst_##E * tree, E * element);\
+\
+lagus_result lagus_persistent_bst_##E##_remove_right (lagus_persistent_bst_##E * tree, E * element);\
+\
+lagus_result lagus_persistent_bst_##E##_remove_at (lagus_persistent_bst_##E * tree, uint64_t index, E * element);\
+\
+lagus_result lagus_persistent_bst_##E##_get_at (lagus_persistent_bst_##E * tree, uint64_t version, uint64_t index, E * element);\
+\
+lagus_result lagus_persistent_bst_iterator_##E##_initialize (lagus_persistent_bst_iterator_##E * iterator, lagus_persistent_bst_##E * tree, uint64_t version);\
+\
+lagus_result lagus_persistent_bst_iterator_##E##_next (lagus_persistent_bst_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_persistent_bst_iterator_##E##_finalize (lagus_persistent_bst_iterator_##E * iterator);
+
+// Implementation
+
+# define lagus_implement_persistent_bst(E) \
+\
+static int64_t lagus_persistent_bst_##E##_binary_compare (E a, E b) {\
+    return lagus_binary_compare ((uint8_t *) & a, (uint8_t *) & b, sizeof (E));\
+}\
+\
+static uint8_t lagus_persistent_bst_##E##_height (lagus_persistent_bst_node_##E * buffer, uint64_t node) {\
+    return node ? buffer [node].height : 0;\
+}\
+\
+static uint64_t lagus_persistent_bst_##E##_subtree_size (lagus_persistent_bst_node_##E * buffer, uint64_t node) {\
+    return node ? buffer [node].size : 0;\
+}\
+\
+static void lagus_persistent_bst_##E##_update (lagus_persistent_bst_node_##E * buffer, uint64_t node) {\
+    uint8_t left_height = lagus_persistent_bst_##E##_height (buffer, buffer [node].left_child);\
+    uint8_t right_height = lagus_persistent_bst_##E##_height (buffer, buffer [node].right_child);\
+    buffer [node].height = (left_height > right_height ? left_height : right_height) + 1;\
+    buffer [node].size = lagus_persistent_bst_##E##_subtree_size (buffer, buffer [node].left_child) + lagus_persistent_bst_##E##_subtree_size (buffer, buffer [node].right_child) + 1;\
+}\
+\
+static lagus_result lagus_persistent_bst_##E##_reserve (lagus_persistent_bst_##E * tree) {\
+    uint64_t root = tree -> versions [0].root;\
+    uint64_t needed = 3 * lagus_persistent_bst_##E##_height (tree -> buffer, root) + 3;\
+    if (tree -> free_size + tree -> capacity - tree -> used >= needed)\
+        return lagus_success;\
+    uint64_t capacity = tree -> capacity;\
+    while (tree -> free_size + capacity - tree -> used < needed)\
+        capacity <<= 1;\
+    lagus_persistent_bst_node_##E * buffer = tree -> memory_management.reallocate (tree -> buffer + 1, capacity * sizeof (lagus_persistent_bst_node_##E));\
+    if (! buffer)\
+        return lagus_memory_allocation;\
+    tree -> capacity = capacity;\
+    tree -> buffer = buffer - 1;\
+    return lagus_success;\
+}\
+\
+static uint64_t lagus_persistent_bst_##E##_take (lagus_persistent_bst_##E * tree) {\
+    uint64_t node = tree -> free;\
+    if (node) {\
+        tree -> free = tree -> buffer [node].left_child;\
+        tree -> free_size --;\
+    } else {\
+        tree -> used ++;\
+        node = tree -> used;\
+    }\
+    return node;\
+}\
+\
+static void lagus_persistent_bst_##E##_discard (lagus_persistent_bst_##E * tree, uint64_t node) {\
+    if (tree -> buffer [node].stamp != tree -> generation)\
+        return;\
+    tree -> buffer [node].size = 0;\
+    tree -> buffer [node].left_child = tree -> free;\
+    tree -> free = node;\
+    tree -> free_size ++;\
+}\
+\
+static uint64_t lagus_persistent_bst_##E##_own (lagus_persistent_bst_##E * tree, uint64_t node) {\
+    if (tree -> buffer [node].stamp == tree -> generation)\
+        return node;\
+    uint64_t copy = lagus_persistent_bst_##E##_take (tree);\
+    tree -> buffer [copy] = tree -> buffer [node];\
+    tree -> buffer [copy].stamp = tree -> generation;\
+    return copy;\
+}\
+\
+static uint64_t lagus_persistent_bst_##E##_rotate_left (lagus_persistent_bst_##E * tree, uint64_t node) {\
+    uint64_t right = lagus_persistent_bst_##E##_own (tree, tree -> buffer [node].right_child);\
+    tree -> buffer [node].right_child = tree -> buffer [right].left_child;\
+    lagus_persistent_bst_##E##_update (tree -> buffer, node);\
+    tree -> buffer [right].left_child = node;\
+    lagus_persistent_bst_##E##_update (tree -> buffer, right);\
+    return right;\
+}\
+\
+static uint64_t lagus_persistent_bst_##E##_rotate_right (lagus_persistent_bst_##E * tree, uint64_t node) {\
+    uint64_t left = lagus_persistent_bst_##E##_own (tree, tree -> buffer [node].left_child);\
+    tree -> buffer [node].left_child = tree -> buffer [left].right_child;\
+    lagus_persistent_bst_##E##_update (tree -> buffer, node);\
+    tree -> buffer [left].right_child = node;\
+    lagus_persistent_bst_##E##_update (tree -> buffer, left);\
+    return left;\
+}\
+\
+static uint64_t lagus_persistent_bst_##E##_balance (lagus_persistent_bst_##E * tree, uint64_t node) {\
+    lagus_persistent_bst_node_##E * buffer = tree -> buffer;\
+    uint64_t left = buffer [node].left_child;\
+    uint64_t right = buffer [node].right_child;\
+    uint8_t left_height = lagus_persistent_bst_##E##_height (buffer, left);\
+    uint8_t right_height = lagus_persistent_bst_##E##_height (buffer, right);\
+    if (left_height > right_height + 1) {\
+        if (lagus_persistent_bst_##E##_height (buffer, buffer [left].left_child) < lagus_persistent_bst_##E##_height (buffer, buffer [left].right_child)) {\
+            left = lagus_persistent_bst_##E##_own (tree, left);\
+            tree -> buffer [node].left_child = lagus_persistent_bst_##E##_rotate_left (tree, left);\
+        }\
+        return lagus_persistent_bst_##E##_rotate_right (tree, node);\
+    }\
+    if (right_height > left_height + 1) {\
+        if (lagus_persistent_bst_##E##_height (buffer, buffer [right].right_child) < lagus_persistent_bst_##E##_height (buffer, buffer [right].left_child)) {\
+            right = lagus_persistent_bst_##E##_own (tree, right);\
+            tree -> buffer [node].right_child = lagus_persistent_bst_##E##_rotate_right (tree, right);\
+        }\
+        return lagus_persistent_bst_##E##_rotate_left (tree, node);\
+    }\
+    lagus_persistent_bst_##E##_update (buffer, node);\
+    return node;\
+}\
+\
+static uint64_t lagus_persistent_bst_##E##_insert (lagus_persistent_bst_##E * tree, uint64_t node, E element, uint8_t direction) {\
+    if (! node) {\
+        node = lagus_persistent_bst_##E##_take (tree);\
+        tree -> buffer [node] = (lagus_persistent_bst_node_##E) {\
+            .left_child = lagus_none,\
+            .right_child = lagus_none,\
+            .size = 1,\
+            .stamp = tree -> generation,\
+            .height = 1,\
+            .element = element\
+        };\
+        return node;\
+    }\
+    node = lagus_persistent_bst_##E##_own (tree, node);\
+    int64_t comparison = tree -> compare (element, tree -> buffer [node].element);\
+    if (comparison < 0 || comparison == 0 && direction == lagus_left) {\
+        uint64_t child = lagus_persistent_bst_##E##_insert (tree, tree -> buffer [node].left_child, element, direction);\
+        tree -> buffer [node].left_child = child;\
+    } else {\
+        uint64_t child = lagus_persistent_bst_##E##_insert (tree, tree -> buffer [node].right_child, element, direction);\
+        tree -> buffer [node].right_child = child;\
+    }\
+    return lagus_persistent_bst_##E##_balance (tree, node);\
+}\
+\
+static uint64_t lagus_persistent_bst_##E##_delete (lagus_persistent_bst_##E * tree, uint64_t node, uint64_t index, E * element) {\
+    node = lagus_persistent_bst_##E##_own (tree, node);\
+    uint64_t left_size = lagus_persistent_bst_##E##_subtree_size (tree -> buffer, tree -> buffer [node].left_child);\
+    if (index <= left_size) {\
+        uint64_t child = lagus_persistent_bst_##E##_delete (tree, tree -> buffer [node].left_child, index, element);\
+        tree -> buffer [node].left_child = child;\
+    } else if (index > left_size + 1) {\
+        uint64_t child = lagus_persistent_bst_##E##_delete (tree, tree -> buffer [node].right_child, index - left_size - 1, element);\
+        tree -> buffer [node].right_child = child;\
+    } else {\
+        * element = tree -> buffer [node].element;\
+        uint64_t left = tree -> buffer [node].left_child;\
+        uint64_t right = tree -> buffer [node].right_child;\
+        if (! left || ! right) {\
+            lagus_persistent_bst_##E##_discard (tree, node);\
+            return left ? left : right;\
+        }\
+        E successor;\
+        uint64_t child = lagus_persistent_bst_##E##_delete (tree, right, 1, & successor);\
+        tree -> buffer [node].right_child = child;\
+        tree -> buffer [node].element = successor;\
+    }\
+    return lagus_persistent_bst_##E##_balance (tree, node);\
+}\
+\
+static lagus_result lagus_persistent_bst_##E##_add (lagus_persistent_bst_##E * tree, E element, uint8_t direction) {\
+    if (lagus_persistent_bst_##E##_reserve (tree))\
+        return lagus_memory_allocation;\
+    tree -> versions [0].root = lagus_persistent_bst_##E##_insert (tree, tree -> versions [0].root, element, direction);\
+    return lagus_success;\
+}\
+\
+static void lagus_persistent_bst_##E##_mark (lagus_persistent_bst_node_##E * buffer, uint8_t * marked, uint64_t node) {\
+    while (node && ! marked [node]) {\
+        marked [node] = 1;\
+        lagus_persistent_bst_##E##_mark (buffer, marked, buffer [node].left_child);\
+        node = buffer [node].right_child;\
+    }\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_initialize (lagus_persistent_bst_##E * tree) {\
+    return lagus_persistent_bst_##E##_custom_initialize (tree, 1, NULL, NULL);\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_custom_initialize (lagus_persistent_bst_##E * tree, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management) {\
+    if (! capacity)\
+        capacity = 1;\
+    if (memory_management)\
+        tree -> memory_management = * memory_management;\
+    else\
+        tree -> memory_management = (lagus_memory_management) {\
+            .allocate = aligned_alloc,\
+            .reallocate = realloc,\
+            .deallocate = free\
+        };\
+    lagus_persistent_bst_node_##E * buffer = tree -> memory_management.allocate (_Alignof (lagus_persistent_bst_node_##E), capacity * sizeof (lagus_persistent_bst_node_##E));\
+    if (! buffer)\
+        return lagus_memory_allocation;\
+    lagus_persistent_bst_version_##E * versions = tree -> memory_management.allocate (_Alignof (lagus_persistent_bst_version_##E), sizeof (lagus_persistent_bst_version_##E));\
+    if (! versions) {\
+        tree -> memory_management.deallocate (buffer);\
+        return lagus_memory_allocation;\
+    }\
+    versions [0] = (lagus_persistent_bst_version_##E) {\
+        .root = lagus_none,\
+        .live = true\
+    };\
+    tree -> generation = 1;\
+    tree -> capacity = capacity;\
+    tree -> used = 0;\
+    tree -> free = lagus_none;\
+    tree -> free_size = 0;\
+    tree -> buffer = buffer - 1;\
+    tree -> versions_capacity = 1;\
+    tree -> versions_size = 1;\
+    tree -> versions = versions;\
+    if (compare)\
+        tree -> compare = compare;\
+    else\
+        tree -> compare = lagus_persistent_bst_##E##_binary_compare;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_finalize (lagus_persistent_bst_##E * tree) {\
+    tree -> memory_management.deallocate (tree -> buffer + 1);\
+    tree -> memory_management.deallocate (tree -> versions);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_snapshot (lagus_persistent_bst_##E * tree, uint64_t * version) {\
+    uint64_t handle = 1;\
+    while (handle < tree -> versions_size && tree -> versions [handle].live)\
+        handle ++;\
+    if (handle == tree -> versions_size) {\
+        if (tree -> versions_size == tree -> versions_capacity) {\
+            uint64_t capacity = tree -> versions_capacity << 1;\
+            lagus_persistent_bst_version_##E * versions = tree -> memory_management.reallocate (tree -> versions, capacity * sizeof (lagus_persistent_bst_version_##E));\
+            if (! versions)\
+                return lagus_memory_allocation;\
+            tree -> versions_capacity = capacity;\
+            tree -> versions = versions;\
+        }\
+        tree -> versions_size ++;\
+    }\
+    tree -> versions [handle] = (lagus_persistent_bst_version_##E) {\
+        .root = tree -> versions [0].root,\
+        .live = true\
+    };\
+    tree -> generation ++;\
+    * version = handle;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_release (lagus_persistent_bst_##E * tree, uint64_t version) {\
+    if (version == 0 || version >= tree -> versions_size || ! tree -> versions [version].live)\
+        return lagus_not_contained;\
+    tree -> versions [version].live = false;\
+    while (tree -> versions_size > 1 && ! tree -> versions [tree -> versions_size - 1].live)\
+        tree -> versions_size --;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_collect (lagus_persistent_bst_##E * tree) {\
+    uint8_t * marked = tree -> memory_management.allocate (_Alignof (uint8_t), tree -> used + 1);\
+    if (! marked)\
+        return lagus_memory_allocation;\
+    for (uint64_t node = 0; node <= tree -> used; node ++)\
+        marked [node] = 0;\
+    uint64_t snapshots = 0;\
+    for (uint64_t version = 0; version < tree -> versions_size; version ++)\
+        if (tree -> versions [version].live) {\
+            lagus_persistent_bst_##E##_mark (tree -> buffer, marked, tree -> versions [version].root);\
+            snapshots ++;\
+        }\
+    if (snapshots == 1)\
+        tree -> generation ++;\
+    while (tree -> used && ! marked [tree -> used])\
+        tree -> used --;\
+    tree -> free = lagus_none;\
+    tree -> free_size = 0;\
+    for (uint64_t node = tree -> used; node; node --) {\
+        if (marked [node]) {\
+            if (snapshots == 1)\
+                tree -> buffer [node].stamp = tree -> generation;\
+        } else {\
+            tree -> buffer [node].size = 0;\
+            tree -> buffer [node].left_child = tree -> free;\
+            tree -> free = node;\
+            tree -> free_size ++;\
+        }\
+    }\
+    tree -> memory_management.deallocate (marked);\
+    uint64_t capacity = tree -> capacity;\
+    while (capacity >= 4 && tree -> used <= capacity >> 2)\
+        capacity >>= 2;\
+    if (capacity != tree -> capacity) {\
+        lagus_persistent_bst_node_##E * buffer = tree -> memory_management.reallocate (tree -> buffer + 1, capacity * sizeof (lagus_persistent_bst_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        tree -> capacity = capacity;\
+        tree -> buffer = buffer - 1;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_size (lagus_persistent_bst_##E * tree, uint64_t version, uint64_t * size) {\
+    * size = lagus_persistent_bst_##E##_subtree_size (tree -> buffer, tree -> versions [version].root);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_add_left (lagus_persistent_bst_##E * tree, E element) {\
+    return lagus_persistent_bst_##E##_add (tree, element, lagus_left);\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_add_right (lagus_persistent_bst_##E * tree, E element) {\
+    return lagus_persistent_bst_##E##_add (tree, element, lagus_right);\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_search_left (lagus_persistent_bst_##E * tree, uint64_t version, E * element, uint64_t * index) {\
+    uint64_t offset = 0;\
+    uint64_t match = lagus_none;\
+    uint64_t node = tree -> versions [version].root;\
+    while (node) {\
+        int64_t comparison = tree -> compare (* element, tree -> buffer [node].element);\
+        uint64_t left_size = lagus_persistent_bst_##E##_subtree_size (tree -> buffer, tree -> buffer [node].left_child);\
+        if (comparison == 0) {\
+            match = node;\
+            * index = offset + left_size + 1;\
+        }\
+        if (comparison > 0) {\
+            offset += left_size + 1;\
+            node = tree -> buffer [node].right_child;\
+        } else\
+            node = tree -> buffer [node].left_child;\
+    }\
+    if (! match)\
+        return lagus_not_contained;\
+    * element = tree -> buffer [match].element;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_search_right (lagus_persistent_bst_##E * tree, uint64_t version, E * element, uint64_t * index) {\
+    uint64_t offset = 0;\
+    uint64_t match = lagus_none;\
+    uint64_t node = tree -> versions [version].root;\
+    while (node) {\
+        int64_t comparison = tree -> compare (* element, tree -> buffer [node].element);\
+        if (comparison < 0)\
+            node = tree -> buffer [node].left_child;\
+        else {\
+            offset += lagus_persistent_bst_##E##_subtree_size (tree -> buffer, tree -> buffer [node].left_child) + 1;\
+            if (comparison == 0) {\
+                match = node;\
+                * index = offset;\
+            }\
+            node = tree -> buffer [node].right_child;\
+        }\
+    }\
+    if (! match)\
+        return lagus_not_contained;\
+    * element = tree -> buffer [match].element;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_remove_left (lagus_persistent_bst_##E * tree, E * element) {\
+    uint64_t index;\
+    if (lagus_persistent_bst_##E##_search_left (tree, 0, element, & index))\
+        return lagus_not_contained;\
+    return lagus_persistent_bst_##E##_remove_at (tree, index, element);\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_remove_right (lagus_persistent_bst_##E * tree, E * element) {\
+    uint64_t index;\
+    if (lagus_persistent_bst_##E##_search_right (tree, 0, element, & index))\
+        return lagus_not_contained;\
+    return lagus_persistent_bst_##E##_remove_at (tree, index, element);\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_remove_at (lagus_persistent_bst_##E * tree, uint64_t index, E * element) {\
+    if (index == 0 || index > lagus_persistent_bst_##E##_subtree_size (tree -> buffer, tree -> versions [0].root))\
+        return lagus_not_contained;\
+    if (lagus_persistent_bst_##E##_reserve (tree))\
+        return lagus_memory_allocation;\
+    tree -> versions [0].root = lagus_persistent_bst_##E##_delete (tree, tree -> versions [0].root, index, element);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_##E##_get_at (lagus_persistent_bst_##E * tree, uint64_t version, uint64_t index, E * element) {\
+    uint64_t node = tree -> versions [version].root;\
+    while (true) {\
+        uint64_t size = lagus_persistent_bst_##E##_subtree_size (tree -> buffer, tree -> buffer [node].left_child);\
+        if (index == size + 1) {\
+            * element = tree -> buffer [node].element;\
+            return lagus_success;\
+        }\
+        if (index <= size)\
+            node = tree -> buffer [node].left_child;\
+        else {\
+            index -= size + 1;\
+            node = tree -> buffer [node].right_child;\
+        }\
+    }\
+}\
+\
+lagus_result lagus_persistent_bst_iterator_##E##_initialize (lagus_persistent_bst_iterator_##E * iterator, lagus_persistent_bst_##E * tree, uint64_t version) {\
+    iterator -> depth = 0;\
+    iterator -> buffer = tree -> buffer;\
+    uint64_t node = tree -> versions [version].root;\
+    while (node) {\
+        iterator -> stack [iterator -> depth] = node;\
+        iterator -> depth ++;\
+        node = tree -> buffer [node].left_child;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_iterator_##E##_next (lagus_persistent_bst_iterator_##E * iterator, E * element) {\
+    if (! iterator -> depth)\
+        return lagus_stop;\
+    iterator -> depth --;\
+    uint64_t node = iterator -> stack [iterator -> depth];\
+    * element = iterator -> buffer [node].element;\
+    node = iterator -> buffer [node].right_child;\
+    while (node) {\
+        iterator -> stack [iterator -> depth] = node;\
+        iterator -> depth ++;\
+        node = iterator -> buffer [node].left_child;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_persistent_bst_iterator_##E##_finalize (lagus_persistent_bst_iterator_##E * iterator) {\
+    return lagus_success;\
+}
+
+/* Adaptive BST */
+
+# define lagus_adaptive_bst_threshold 64
+
+// Declaration
+
+# define lagus_declare_adaptive_bst(E) \
+\
+typedef struct lagus_adaptive_bst_##E {\
+    bool large;\
+    uint64_t threshold;\
+    uint64_t size;\
+    E * elements;\
+    lagus_bst_##E bst;\
+    lagus_compare_##E compare;\
+    lagus_memory_management memory_management;\
+} lagus_adaptive_bst_##E;\
+\
+typedef struct lagus_adaptive_bst_iterator_##E {\
+    bool large;\
+    uint64_t index;\
+    uint64_t size;\
+    E * elements;\
+    lagus_bst_iterator_##E iterator;\
+} lagus_adaptive_bst_iterator_##E;\
+\
+lagus_result lagus_adaptive_bst_##E##_initialize (lagus_adaptive_bst_##E * tree);\
+\
+lagus_result lagus_adaptive_bst_##E##_custom_initialize (lagus_adaptive_bst_##E * tree, uint64_t threshold, lagus_compare_##E compare, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_adaptive_bst_##E##_finalize (lagus_adaptive_bst_##E * tree);\
+\
+lagus_result lagus_adaptive_bst_##E##_size (lagus_adaptive_bst_##E * tree, uint64_t * size);\
+\
+lagus_result lagus_adaptive_bst_##E##_add_left (lagus_adaptive_bst_##E * tree, E element);\
+\
+lagus_result lagus_adaptive_bst_##E##_add_right (lagus_adaptive_bst_##E * tree, E element);\
+\
+lagus_result lagus_adaptive_bst_##E##_search_left (lagus_adaptive_bst_##E * tree, E * element, uint64_t * index);\
+\
+lagus_result lagus_adaptive_bst_##E##_search_right (lagus_adaptive_bst_##E * tree, E * element, uint64_t * index);\
+\
+lagus_result lagus_adaptive_bst_##E##_remove_left (lagus_adaptive_bst_##E * tree, E * element);\
+\
+lagus_result lagus_adaptive_bst_##E##_remove_right (lagus_adaptive_bst_##E * tree, E * element);\
+\
+lagus_result lagus_adaptive_bst_##E##_remove_at (lagus_adaptive_bst_##E * tree, uint64_t index, E * element);\
+\
+lagus_result lagus_adaptive_bst_##E##_get_at (lagus_adaptive_bst_##E * tree, uint64_t index, E * element);\
+\
+lagus_result lagus_adaptive_bst_iterator_##E##_initialize (lagus_adaptive_bst_iterator_##E * iterator, lagus_adaptive_bst_##E * tree);\
+\
+lagus_result lagus_adaptive_bst_iterator_##E##_next (lagus_adaptive_bst_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_adaptive_bst_iterator_##E##_finalize (lagus_adaptive_bst_iterator_##E * iterator);
+
+// Implementation
+
+# define lagus_implement_adaptive_bst(E) \
+\
+static uint64_t lagus_adaptive_bst_##E##_bound (lagus_adaptive_bst_##E * tree, E * element, bool inclusive) {\
+    uint64_t count = tree -> size;\
+    if (! count)\
+        return 0;\
+    int64_t threshold = inclusive;\
+    uint64_t low = 0;\
+    while (count > 1) {\
+        uint64_t half = count >> 1;\
+        low += (lagus_bst_##E##_compare (tree -> compare, tree -> elements [low + half], * element) < threshold) * half;\
+        count -= half;\
+    }\
+    return low + (lagus_bst_##E##_compare (tree -> compare, tree -> elements [low], * element) < threshold);\
+}\
+\
+static lagus_result lagus_adaptive_bst_##E##_add (lagus_adaptive_bst_##E * tree, E element, uint8_t direction) {\
+    if (! tree -> large && tree -> size == tree -> threshold) {\
+        if (lagus_bst_##E##_custom_initialize (& tree -> bst, tree -> threshold << 1, tree -> compare, & tree -> memory_management))\
+            return lagus_memory_allocation;\
+        lagus_bst_##E##_build_sorted (& tree -> bst, tree -> elements, tree -> size);\
+        tree -> large = true;\
+    }\
+    if (tree -> large) {\
+        lagus_result result;\
+        if (direction == lagus_left)\
+            result = lagus_bst_##E##_add_left (& tree -> bst, element);\
+        else\
+            result = lagus_bst_##E##_add_right (& tree -> bst, element);\
+        if (result)\
+            return result;\
+    } else {\
+        uint64_t position = lagus_adaptive_bst_##E##_bound (tree, & element, direction == lagus_right);\
+        __builtin_memmove (tree -> elements + position + 1, tree -> elements + position, (tree -> size - position) * sizeof (E));\
+        tree -> elements [position] = element;\
+    }\
+    tree -> size ++;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_initialize (lagus_adaptive_bst_##E * tree) {\
+    return lagus_adaptive_bst_##E##_custom_initialize (tree, 0, NULL, NULL);\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_custom_initialize (lagus_adaptive_bst_##E * tree, uint64_t threshold, lagus_compare_##E compare, lagus_memory_management * memory_management) {\
+    if (! threshold)\
+        threshold = lagus_adaptive_bst_threshold;\
+    if (memory_management)\
+        tree -> memory_management = * memory_management;\
+    else\
+        tree -> memory_management = (lagus_memory_management) {\
+            .allocate = aligned_alloc,\
+            .reallocate = realloc,\
+            .deallocate = free\
+        };\
+    tree -> elements = tree -> memory_management.allocate (_Alignof (E), threshold * sizeof (E));\
+    if (! tree -> elements)\
+        return lagus_memory_allocation;\
+    tree -> large = false;\
+    tree -> threshold = threshold;\
+    tree -> size = 0;\
+    if (compare)\
+        tree -> compare = compare;\
+    else\
+        tree -> compare = lagus_binary_compare_##E;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_finalize (lagus_adaptive_bst_##E * tree) {\
+    if (tree -> large)\
+        lagus_bst_##E##_finalize (& tree -> bst);\
+    tree -> memory_management.deallocate (tree -> elements);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_size (lagus_adaptive_bst_##E * tree, uint64_t * size) {\
+    * size = tree -> size;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_add_left (lagus_adaptive_bst_##E * tree, E element) {\
+    return lagus_adaptive_bst_##E##_add (tree, element, lagus_left);\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_add_right (lagus_adaptive_bst_##E * tree, E element) {\
+    return lagus_adaptive_bst_##E##_add (tree, element, lagus_right);\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_search_left (lagus_adaptive_bst_##E * tree, E * element, uint64_t * index) {\
+    if (tree -> large)\
+        return lagus_bst_##E##_search_left (& tree -> bst, element, index);\
+    uint64_t position = lagus_adaptive_bst_##E##_bound (tree, element, false);\
+    if (position == tree -> size || lagus_bst_##E##_compare (tree -> compare, tree -> elements [position], * element))\
+        return lagus_not_contained;\
+    * element = tree -> elements [position];\
+    * index = position + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_search_right (lagus_adaptive_bst_##E * tree, E * element, uint64_t * index) {\
+    if (tree -> large)\
+        return lagus_bst_##E##_search_right (& tree -> bst, element, index);\
+    uint64_t position = lagus_adaptive_bst_##E##_bound (tree, element, true);\
+    if (position == 0 || lagus_bst_##E##_compare (tree -> compare, tree -> elements [position - 1], * element))\
+        return lagus_not_contained;\
+    * element = tree -> elements [position - 1];\
+    * index = position;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_remove_left (lagus_adaptive_bst_##E * tree, E * element) {\
+    uint64_t index;\
+    if (lagus_adaptive_bst_##E##_search_left (tree, element, & index))\
+        return lagus_not_contained;\
+    return lagus_adaptive_bst_##E##_remove_at (tree, index, element);\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_remove_right (lagus_adaptive_bst_##E * tree, E * element) {\
+    uint64_t index;\
+    if (lagus_adaptive_bst_##E##_search_right (tree, element, & index))\
+        return lagus_not_contained;\
+    return lagus_adaptive_bst_##E##_remove_at (tree, index, element);\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_remove_at (lagus_adaptive_bst_##E * tree, uint64_t index, E * element) {\
+    if (index == 0 || index > tree -> size)\
+        return lagus_not_contained;\
+    if (tree -> large) {\
+        lagus_result result = lagus_bst_##E##_remove_at (& tree -> bst, index, element);\
+        if (result)\
+            return result;\
+        tree -> size --;\
+        if (tree -> size <= tree -> threshold >> 1) {\
+            if (tree -> size)\
+                lagus_bst_##E##_flatten (tree -> bst.buffer, lagus_root, tree -> elements);\
+            lagus_bst_##E##_finalize (& tree -> bst);\
+            tree -> large = false;\
+        }\
+        return lagus_success;\
+    }\
+    * element = tree -> elements [index - 1];\
+    __builtin_memmove (tree -> elements + index - 1, tree -> elements + index, (tree -> size - index) * sizeof (E));\
+    tree -> size --;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_##E##_get_at (lagus_adaptive_bst_##E * tree, uint64_t index, E * element) {\
+    if (tree -> large)\
+        return lagus_bst_##E##_get_at (& tree -> bst, index, element);\
+    * element = tree -> elements [index - 1];\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_iterator_##E##_initialize (lagus_adaptive_bst_iterator_##E * iterator, lagus_adaptive_bst_##E * tree) {\
+    iterator -> large = tree -> large;\
+    if (tree -> large)\
+        return lagus_bst_iterator_##E##_initialize (& iterator -> iterator, & tree -> bst);\
+    iterator -> index = 0;\
+    iterator -> size = tree -> size;\
+    iterator -> elements = tree -> elements;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_iterator_##E##_next (lagus_adaptive_bst_iterator_##E * iterator, E * element) {\
+    if (iterator -> large)\
+        return lagus_bst_iterator_##E##_next (& iterator -> iterator, element);\
+    if (iterator -> index == iterator -> size)\
+        return lagus_stop;\
+    * element = iterator -> elements [iterator -> index];\
+    iterator -> index ++;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_adaptive_bst_iterator_##E##_finalize (lagus_adaptive_bst_iterator_##E * iterator) {\
+    if (iterator -> large)\
+        return lagus_bst_iterator_##E##_finalize (& iterator -> iterator);\
+    return lagus_success;\
+}
+
+/* Bounded BST */
+
+// Declaration
+
+# define lagus_declare_bounded_bst(E) \
+\
+typedef struct lagus_bounded_bst_##E {\
+    bool largest;\
+    uint64_t limit;\
+    E threshold;\
+    lagus_bst_##E bst;\
+} lagus_bounded_bst_##E;\
+\
+typedef lagus_bst_iterator_##E lagus_bounded_bst_iterator_##E;\
+\
+lagus_result lagus_bounded_bst_##E##_initialize (lagus_bounded_bst_##E * tree, uint64_t limit, bool largest);\
+\
+lagus_result lagus_bounded_bst_##E##_custom_initialize (lagus_bounded_bst_##E * tree, uint64_t limit, bool largest, lagus_compare_##E compare, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_bounded_bst_##E##_finalize (lagus_bounded_bst_##E * tree);\
+\
+lagus_result lagus_bounded_bst_##E##_size (lagus_bounded_bst_##E * tree, uint64_t * size);\
+\
+lagus_result lagus_bounded_bst_##E##_threshold (lagus_bounded_bst_##E * tree, E * element);\
+\
+lagus_result lagus_bounded_bst_##E##_add (lagus_bounded_bst_##E * tree, E element);\
+\
+lagus_result lagus_bounded_bst_##E##_get_at (lagus_bounded_bst_##E * tree, uint64_t index, E * element);\
+\
+lagus_result lagus_bounded_bst_iterator_##E##_initialize (lagus_bounded_bst_iterator_##E * iterator, lagus_bounded_bst_##E * tree);\
+\
+lagus_result lagus_bounded_bst_iterator_##E##_next (lagus_bounded_bst_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_bounded_bst_iterator_##E##_finalize (lagus_bounded_bst_iterator_##E * iterator);
+
+// Implementation
+
+# define lagus_implement_bounded_bst(E) \
+\
+lagus_result lagus_bounded_bst_##E##_initialize (lagus_bounded_bst_##E * tree, uint64_t limit, bool largest) {\
+    return lagus_bounded_bst_##E##_custom_initialize (tree, limit, largest, NULL, NULL);\
+}\
+\
+lagus_result lagus_bounded_bst_##E##_custom_initialize (lagus_bounded_bst_##E * tree, uint64_t limit, bool largest, lagus_compare_##E compare, lagus_memory_management * memory_management) {\
+    if (! limit)\
+        limit = 1;\
+    lagus_result result = lagus_bst_##E##_custom_initialize (& tree -> bst, limit, compare, memory_management);\
+    if (result)\
+        return result;\
+    tree -> largest = largest;\
+    tree -> limit = limit;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_bounded_bst_##E##_finalize (lagus_bounded_bst_##E * tree) {\
+    return lagus_bst_##E##_finalize (& tree -> bst);\
+}\
+\
+lagus_result lagus_bounded_bst_##E##_size (lagus_bounded_bst_##E * tree, uint64_t * size) {\
+    return lagus_bst_##E##_size (& tree -> bst, size);\
+}\
+\
+lagus_result lagus_bounded_bst_##E##_threshold (lagus_bounded_bst_##E * tree, E * element) {\
+    if (tree -> bst.height == 0)\
+        return lagus_not_contained;\
+    * element = tree -> threshold;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_bounded_bst_##E##_add (lagus_bounded_bst_##E * tree, E element) {\
+    uint64_t size = tree -> bst.buffer [lagus_root].size;\
+    lagus_result result;\
+    if (size < tree -> limit) {\
+        if (tree -> largest)\
+            result = lagus_bst_##E##_add_right (& tree -> bst, element);\
+        else\
+            result = lagus_bst_##E##_add_left (& tree -> bst, element);\
+        if (result)\
+            return result;\
+        size ++;\
+    } else {\
+        int64_t comparison = lagus_bst_##E##_compare (tree -> bst.compare, element, tree -> threshold);\
+        if (tree -> largest ? comparison <= 0 : comparison >= 0)\
+            return lagus_not_contained;\
+        E evicted;\
+        if (tree -> largest) {\
+            if (size > 1 && lagus_bst_##E##_get_at (& tree -> bst, 2, & evicted) == lagus_success && lagus_bst_##E##_compare (tree -> bst.compare, element, evicted) <= 0) {\
+                tree -> threshold = element;\
+                lagus_bst_##E##_set_at (& tree -> bst, 1, & element);\
+                return lagus_success;\
+            }\
+            lagus_bst_##E##_remove_at (& tree -> bst, 1, & evicted);\
+            result = lagus_bst_##E##_add_right (& tree -> bst, element);\
+        } else {\
+            if (size > 1 && lagus_bst_##E##_get_at (& tree -> bst, size - 1, & evicted) == lagus_success && lagus_bst_##E##_compare (tree -> bst.compare, element, evicted) >= 0) {\
+                tree -> threshold = element;\
+                lagus_bst_##E##_set_at (& tree -> bst, size, & element);\
+                return lagus_success;\
+            }\
+            lagus_bst_##E##_remove_at (& tree -> bst, size, & evicted);\
+            result = lagus_bst_##E##_add_left (& tree -> bst, element);\
+        }\
+        if (result)\
+            return result;\
+    }\
+    if (tree -> largest)\
+        lagus_bst_##E##_get_at (& tree -> bst, 1, & tree -> threshold);\
+    else\
+        lagus_bst_##E##_get_at (& tree -> bst, size, & tree -> threshold);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_bounded_bst_##E##_get_at (lagus_bounded_bst_##E * tree, uint64_t index, E * element) {\
+    return lagus_bst_##E##_get_at (& tree -> bst, index, element);\
+}\
+\
+lagus_result lagus_bounded_bst_iterator_##E##_initialize (lagus_bounded_bst_iterator_##E * iterator, lagus_bounded_bst_##E * tree) {\
+    return lagus_bst_iterator_##E##_initialize (iterator, & tree -> bst);\
+}\
+\
+lagus_result lagus_bounded_bst_iterator_##E##_next (lagus_bounded_bst_iterator_##E * iterator, E * element) {\
+    return lagus_bst_iterator_##E##_next (iterator, element);\
+}\
+\
+lagus_result lagus_bounded_bst_iterator_##E##_finalize (lagus_bounded_bst_iterator_##E * iterator) {\
+    return lagus_bst_iterator_##E##_finalize (iterator);\
+}
+
+/* Aggregate BST */
+
+// Declaration
+
+# define lagus_declare_aggregate_bst(E, A) \
+\
+typedef int64_t (* lagus_compare_##E) (E, E);\
+\
+lagus_declare_bst_named(E, aggregate_bst, A aggregate;)\
+\
+lagus_result lagus_aggregate_bst_##E##_aggregate (lagus_aggregate_bst_##E * bst, A * aggregate);\
+\
+lagus_result lagus_aggregate_bst_##E##_range_aggregate (lagus_aggregate_bst_##E * bst, E * lower, E * upper, A * aggregate);\
+\
+lagus_result lagus_aggregate_bst_##E##_range_aggregate_at (lagus_aggregate_bst_##E * bst, uint64_t first, uint64_t last, A * aggregate);
+
+// Implementation
+
+# define lagus_implement_aggregate_bst(E, A, I, M, O) lagus_implement_aggregate_bst_inline(E, A, I, M, O, compare)
+
+# define lagus_implement_aggregate_bst_inline(E, A, I, M, O, C) \
+\
+static int64_t lagus_aggregate_bst_##E##_binary_compare (E a, E b) {\
+    return lagus_binary_compare ((uint8_t *) & a, (uint8_t *) & b, sizeof (E));\
+}\
+\
+static void lagus_aggregate_bst_##E##_update (lagus_aggregate_bst_node_##E * buffer, uint64_t node) {\
+    A aggregate = M (buffer [node].element);\
+    uint64_t child = buffer [node].left_child;\
+    if (child)\
+        aggregate = O (buffer [child].aggregate, aggregate);\
+    child = buffer [node].right_child;\
+    if (child)\
+        aggregate = O (aggregate, buffer [child].aggregate);\
+    buffer [node].aggregate = aggregate;\
+}\
+\
+lagus_implement_bst_named(E, aggregate_bst, C, lagus_aggregate_bst_##E##_binary_compare, lagus_aggregate_bst_##E##_update)\
+\
+lagus_result lagus_aggregate_bst_##E##_set_at (lagus_aggregate_bst_##E * bst, uint64_t index, E * element) {\
+    uint64_t node = lagus_root;\
+    while (true) {\
+        uint64_t left_child = bst -> buffer [node].left_child;\
+        uint64_t size;\
+        if (left_child)\
+            size = bst -> buffer [left_child].size;\
+        else\
+            size = 0;\
+        if (index == size + 1)\
+            break;\
+        if (index <= size)\
+            node = left_child;\
+        else {\
+            index -= size + 1;\
+            node = bst -> buffer [node].right_child;\
+        }\
+    }\
+    E temporal = bst -> buffer [node].element;\
+    bst -> buffer [node].element = * element;\
+    * element = temporal;\
+    while (node) {\
+        lagus_aggregate_bst_##E##_update (bst -> buffer, node);\
+        node = bst -> buffer [node].parent;\
+    }\
+    return lagus_success;\
+}\
+\
+static A lagus_aggregate_bst_##E##_fold (lagus_aggregate_bst_node_##E * buffer, uint64_t node, uint64_t start, uint64_t end) {\
+    A aggregate = I;\
+    while (node && start < end) {\
+        if (start == 0 && end >= buffer [node].size)\
+            return O (aggregate, buffer [node].aggregate);\
+        uint64_t left_child = buffer [node].left_child;\
+        uint64_t size = 0;\
+        if (left_child)\
+            size = buffer [left_child].size;\
+        if (end <= size) {\
+            node = left_child;\
+            continue;\
+        }\
+        if (start > size) {\
+            start -= size + 1;\
+            end -= size + 1;\
+            node = buffer [node].right_child;\
+            continue;\
+        }\
+        if (start < size)\
+            aggregate = O (aggregate, lagus_aggregate_bst_##E##_fold (buffer, left_child, start, size));\
+        aggregate = O (aggregate, M (buffer [node].element));\
+        start = 0;\
+        end -= size + 1;\
+        node = buffer [node].right_child;\
+    }\
+    return aggregate;\
+}\
+\
+lagus_result lagus_aggregate_bst_##E##_aggregate (lagus_aggregate_bst_##E * bst, A * aggregate) {\
+    if (bst -> height == 0)\
+        * aggregate = I;\
+    else\
+        * aggregate = bst -> buffer [lagus_root].aggregate;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_aggregate_bst_##E##_range_aggregate (lagus_aggregate_bst_##E * bst, E * lower, E * upper, A * aggregate) {\
+    uint64_t start = 0;\
+    uint64_t end = bst -> buffer [lagus_root].size;\
+    if (lower)\
+        start = lagus_aggregate_bst_##E##_rank (bst, lower, false);\
+    if (upper)\
+        end = lagus_aggregate_bst_##E##_rank (bst, upper, true);\
+    * aggregate = lagus_aggregate_bst_##E##_fold (bst -> buffer, lagus_root, start, end);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_aggregate_bst_##E##_range_aggregate_at (lagus_aggregate_bst_##E * bst, uint64_t first, uint64_t last, A * aggregate) {\
+    * aggregate = lagus_aggregate_bst_##E##_fold (bst -> buffer, lagus_root, first - 1, last);\
+    return lagus_success;\
+}
+
+/* Interval tree */
+
+// Declaration
+
+# define lagus_declare_interval_tree(E, P) \
+\
+lagus_declare_aggregate_bst(E, P)\
+\
+typedef lagus_aggregate_bst_##E lagus_interval_tree_##E;\
+\
+typedef struct lagus_interval_tree_iterator_##E {\
+    uint64_t node;\
+    P lower;\
+    P upper;\
+    lagus_aggregate_bst_node_##E * buffer;\
+} lagus_interval_tree_iterator_##E;\
+\
+lagus_result lagus_interval_tree_##E##_initialize (lagus_interval_tree_##E * tree);\
+\
+lagus_result lagus_interval_tree_##E##_custom_initialize (lagus_interval_tree_##E * tree, uint64_t capacity, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_interval_tree_##E##_finalize (lagus_interval_tree_##E * tree);\
+\
+lagus_result lagus_interval_tree_##E##_size (lagus_interval_tree_##E * tree, uint64_t * size);\
+\
+lagus_result lagus_interval_tree_##E##_add (lagus_interval_tree_##E * tree, E element);\
+\
+lagus_result lagus_interval_tree_##E##_remove (lagus_interval_tree_##E * tree, E * element);\
+\
+lagus_result lagus_interval_tree_iterator_##E##_initialize (lagus_interval_tree_iterator_##E * iterator, lagus_interval_tree_##E * tree, P lower, P upper);\
+\
+lagus_result lagus_interval_tree_iterator_##E##_next (lagus_interval_tree_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_interval_tree_iterator_##E##_finalize (lagus_interval_tree_iterator_##E * iterator);
+
+// Implementation
+
+# define lagus_implement_interval_tree(E, P, L, S, F) \
+\
+static P lagus_interval_tree_##E##_maximum (P a, P b) {\
+    if (a < b)\
+        return b;\
+    return a;\
+}\
+\
+static int64_t lagus_interval_tree_##E##_compare (E a, E b) {\
+    if (S (a) < S (b))\
+        return -1;\
+    if (S (a) > S (b))\
+        return 1;\
+    if (F (a) < F (b))\
+        return -1;\
+    if (F (a) > F (b))\
+        return 1;\
+    return 0;\
+}\
+\
+lagus_implement_aggregate_bst_inline(E, P, L, F, lagus_interval_tree_##E##_maximum, lagus_interval_tree_##E##_compare)\
+\
+lagus_result lagus_interval_tree_##E##_initialize (lagus_interval_tree_##E * tree) {\
+    return lagus_aggregate_bst_##E##_custom_initialize (tree, 1, lagus_interval_tree_##E##_compare, NULL);\
+}\
+\
+lagus_result lagus_interval_tree_##E##_custom_initialize (lagus_interval_tree_##E * tree, uint64_t capacity, lagus_memory_management * memory_management) {\
+    return lagus_aggregate_bst_##E##_custom_initialize (tree, capacity, lagus_interval_tree_##E##_compare, memory_management);\
+}\
+\
+lagus_result lagus_interval_tree_##E##_finalize (lagus_interval_tree_##E * tree) {\
+    return lagus_aggregate_bst_##E##_finalize (tree);\
+}\
+\
+lagus_result lagus_interval_tree_##E##_size (lagus_interval_tree_##E * tree, uint64_t * size) {\
+    return lagus_aggregate_bst_##E##_size (tree, size);\
+}\
+\
+lagus_result lagus_interval_tree_##E##_add (lagus_interval_tree_##E * tree, E element) {\
+    return lagus_aggregate_bst_##E##_add_right (tree, element);\
+}\
+\
+lagus_result lagus_interval_tree_##E##_remove (lagus_interval_tree_##E * tree, E * element) {\
+    return lagus_aggregate_bst_##E##_remove_left (tree, element);\
+}\
+\
+static uint64_t lagus_interval_tree_##E##_first (lagus_aggregate_bst_node_##E * buffer, uint64_t node, P lower, P upper) {\
+    while (node && lower < buffer [node].aggregate) {\
+        uint64_t left_child = buffer [node].left_child;\
+        if (left_child && lower < buffer [left_child].aggregate) {\
+            node = left_child;\
+            continue;\
+        }\
+        if (upper < S (buffer [node].element))\
+            return lagus_none;\
+        if (lower < F (buffer [node].element))\
+            return node;\
+        node = buffer [node].right_child;\
+    }\
+    return lagus_none;\
+}\
+\
+lagus_result lagus_interval_tree_iterator_##E##_initialize (lagus_interval_tree_iterator_##E * iterator, lagus_interval_tree_##E * tree, P lower, P upper) {\
+    * iterator = (lagus_interval_tree_iterator_##E) {\
+        .node = lagus_none,\
+        .lower = lower,\
+        .upper = upper,\
+        .buffer = tree -> buffer\
+    };\
+    if (tree -> height)\
+        iterator -> node = lagus_interval_tree_##E##_first (tree -> buffer, lagus_root, lower, upper);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_interval_tree_iterator_##E##_next (lagus_interval_tree_iterator_##E * iterator, E * element) {\
+    lagus_aggregate_bst_node_##E * buffer = iterator -> buffer;\
+    uint64_t node = iterator -> node;\
+    if (! node)\
+        return lagus_stop;\
+    * element = buffer [node].element;\
+    iterator -> node = lagus_interval_tree_##E##_first (buffer, buffer [node].right_child, iterator -> lower, iterator -> upper);\
+    while (! iterator -> node) {\
+        uint64_t parent = buffer [node].parent;\
+        if (! parent)\
+            break;\
+        if (buffer [parent].left_child == node) {\
+            if (iterator -> upper < S (buffer [parent].element))\
+                break;\
+            if (iterator -> lower < F (buffer [parent].element)) {\
+                iterator -> node = parent;\
+                break;\
+            }\
+            iterator -> node = lagus_interval_tree_##E##_first (buffer, buffer [parent].right_child, iterator -> lower, iterator -> upper);\
+        }\
+        node = parent;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_interval_tree_iterator_##E##_finalize (lagus_interval_tree_iterator_##E * iterator) {\
+    return lagus_success;\
+}
+
+/* Multiset */
+
+// Declaration
+
+# define lagus_declare_multiset(E) \
+\
+typedef struct lagus_multiset_entry_##E {\
+    E element;\
+    uint64_t count;\
+} lagus_multiset_entry_##E;\
+\
+lagus_declare_aggregate_bst(lagus_multiset_entry_##E, uint64_t)\
+\
+typedef lagus_aggregate_bst_lagus_multiset_entry_##E lagus_multiset_##E;\
+\
+typedef lagus_aggregate_bst_iterator_lagus_multiset_entry_##E lagus_multiset_iterator_##E;\
+\
+lagus_result lagus_multiset_##E##_initialize (lagus_multiset_##E * multiset);\
+\
+lagus_result lagus_multiset_##E##_custom_initialize (lagus_multiset_##E * multiset, uint64_t capacity, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_multiset_##E##_finalize (lagus_multiset_##E * multiset);\
+\
+lagus_result lagus_multiset_##E##_size (lagus_multiset_##E * multiset, uint64_t * size);\
+\
+lagus_result lagus_multiset_##E##_distinct (lagus_multiset_##E * multiset, uint64_t * size);\
+\
+lagus_result lagus_multiset_##E##_add (lagus_multiset_##E * multiset, E element, uint64_t count);\
+\
+lagus_result lagus_multiset_##E##_remove (lagus_multiset_##E * multiset, E element, uint64_t * count);\
+\
+lagus_result lagus_multiset_##E##_count (lagus_multiset_##E * multiset, E element, uint64_t * count);\
+\
+lagus_result lagus_multiset_##E##_rank_left (lagus_multiset_##E * multiset, E element, uint64_t * index);\
+\
+lagus_result lagus_multiset_##E##_rank_right (lagus_multiset_##E * multiset, E element, uint64_t * index);\
+\
+lagus_result lagus_multiset_##E##_get_at (lagus_multiset_##E * multiset, uint64_t index, E * element);\
+\
+lagus_result lagus_multiset_iterator_##E##_initialize (lagus_multiset_iterator_##E * iterator, lagus_multiset_##E * multiset);\
+\
+lagus_result lagus_multiset_iterator_##E##_next (lagus_multiset_iterator_##E * iterator, E * element, uint64_t * count);\
+\
+lagus_result lagus_multiset_iterator_##E##_finalize (lagus_multiset_iterator_##E * iterator);
+
+// Implementation
+
+# define lagus_implement_multiset(E, C) \
+\
+static uint64_t lagus_multiset_##E##_multiplicity (lagus_multiset_entry_##E entry) {\
+    return entry.count;\
+}\
+\
+static uint64_t lagus_multiset_##E##_sum (uint64_t a, uint64_t b) {\
+    return a + b;\
+}\
+\
+static int64_t lagus_multiset_##E##_compare (lagus_multiset_entry_##E a, lagus_multiset_entry_##E b) {\
+    return C (a.element, b.element);\
+}\
+\
+lagus_implement_aggregate_bst_inline(lagus_multiset_entry_##E, uint64_t, 0, lagus_multiset_##E##_multiplicity, lagus_multiset_##E##_sum, lagus_multiset_##E##_compare)\
+\
+static uint64_t lagus_multiset_##E##_rank (lagus_multiset_##E * multiset, E element, bool inclusive) {\
+    if (multiset -> height == 0)\
+        return 0;\
+    lagus_aggregate_bst_node_lagus_multiset_entry_##E * buffer = multiset -> buffer;\
+    uint64_t count = 0;\
+    uint64_t node = lagus_root;\
+    while (node) {\
+        int64_t comparison = C (element, buffer [node].element.element);\
+        if (comparison < 0 || ! inclusive && comparison == 0)\
+            node = buffer [node].left_child;\
+        else {\
+            uint64_t left_child = buffer [node].left_child;\
+            if (left_child)\
+                count += buffer [left_child].aggregate;\
+            count += buffer [node].element.count;\
+            node = buffer [node].right_child;\
+        }\
+    }\
+    return count;\
+}\
+\
+lagus_result lagus_multiset_##E##_initialize (lagus_multiset_##E * multiset) {\
+    return lagus_aggregate_bst_lagus_multiset_entry_##E##_custom_initialize (multiset, 1, lagus_multiset_##E##_compare, NULL);\
+}\
+\
+lagus_result lagus_multiset_##E##_custom_initialize (lagus_multiset_##E * multiset, uint64_t capacity, lagus_memory_management * memory_management) {\
+    return lagus_aggregate_bst_lagus_multiset_entry_##E##_custom_initialize (multiset, capacity, lagus_multiset_##E##_compare, memory_management);\
+}\
+\
+lagus_result lagus_multiset_##E##_finalize (lagus_multiset_##E * multiset) {\
+    return lagus_aggregate_bst_lagus_multiset_entry_##E##_finalize (multiset);\
+}\
+\
+lagus_result lagus_multiset_##E##_size (lagus_multiset_##E * multiset, uint64_t * size) {\
+    return lagus_aggregate_bst_lagus_multiset_entry_##E##_aggregate (multiset, size);\
+}\
+\
+lagus_result lagus_multiset_##E##_distinct (lagus_multiset_##E * multiset, uint64_t * size) {\
+    return lagus_aggregate_bst_lagus_multiset_entry_##E##_size (multiset, size);\
+}\
+\
+lagus_result lagus_multiset_##E##_add (lagus_multiset_##E * multiset, E element, uint64_t count) {\
+    if (! count)\
+        return lagus_success;\
+    lagus_multiset_entry_##E entry = {\
+        .element = element,\
+        .count = count\
+    };\
+    uint64_t index;\
+    if (lagus_aggregate_bst_lagus_multiset_entry_##E##_search_left (multiset, & entry, & index))\
+        return lagus_aggregate_bst_lagus_multiset_entry_##E##_add_right (multiset, entry);\
+    entry.count += count;\
+    return lagus_aggregate_bst_lagus_multiset_entry_##E##_set_at (multiset, index, & entry);\
+}\
+\
+lagus_result lagus_multiset_##E##_remove (lagus_multiset_##E * multiset, E element, uint64_t * count) {\
+    lagus_multiset_entry_##E entry = {\
+        .element = element\
+    };\
+    uint64_t index;\
+    if (lagus_aggregate_bst_lagus_multiset_entry_##E##_search_left (multiset, & entry, & index))\
+        return lagus_not_contained;\
+    if (* count >= entry.count) {\
+        * count = entry.count;\
+        return lagus_aggregate_bst_lagus_multiset_entry_##E##_remove_at (multiset, index, & entry);\
+    }\
+    entry.count -= * count;\
+    return lagus_aggregate_bst_lagus_multiset_entry_##E##_set_at (multiset, index, & entry);\
+}\
+\
+lagus_result lagus_multiset_##E##_count (lagus_multiset_##E * multiset, E element, uint64_t * count) {\
+    lagus_multiset_entry_##E entry = {\
+        .element = element\
+    };\
+    uint64_t index;\
+    if (lagus_aggregate_bst_lagus_multiset_entry_##E##_search_left (multiset, & entry, & index))\
+        * count = 0;\
+    else\
+        * count = entry.count;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_multiset_##E##_rank_left (lagus_multiset_##E * multiset, E element, uint64_t * index) {\
+    * index = lagus_multiset_##E##_rank (multiset, element, false) + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_multiset_##E##_rank_right (lagus_multiset_##E * multiset, E element, uint64_t * index) {\
+    * index = lagus_multiset_##E##_rank (multiset, element, true) + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_multiset_##E##_get_at (lagus_multiset_##E * multiset, uint64_t index, E * element) {\
+    lagus_aggregate_bst_node_lagus_multiset_entry_##E * buffer = multiset -> buffer;\
+    uint64_t node = lagus_root;\
+    while (true) {\
+        uint64_t left_child = buffer [node].left_child;\
+        uint64_t count = 0;\
+        if (left_child)\
+            count = buffer [left_child].aggregate;\
+        if (index <= count)\
+            node = left_child;\
+        else {\
+            index -= count;\
+            if (index <= buffer [node].element.count) {\
+                * element = buffer [node].element.element;\
+                return lagus_success;\
+            }\
+            index -= buffer [node].element.count;\
+            node = buffer [node].right_child;\
+        }\
+    }\
+}\
+\
+lagus_result lagus_multiset_iterator_##E##_initialize (lagus_multiset_iterator_##E * iterator, lagus_multiset_##E * multiset) {\
+    return lagus_aggregate_bst_iterator_lagus_multiset_entry_##E##_initialize (iterator, multiset);\
+}\
+\
+lagus_result lagus_multiset_iterator_##E##_next (lagus_multiset_iterator_##E * iterator, E * element, uint64_t * count) {\
+    lagus_multiset_entry_##E entry;\
+    lagus_result result = lagus_aggregate_bst_iterator_lagus_multiset_entry_##E##_next (iterator, & entry);\
+    if (result)\
+        return result;\
+    * element = entry.element;\
+    * count = entry.count;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_multiset_iterator_##E##_finalize (lagus_multiset_iterator_##E * iterator) {\
+    return lagus_aggregate_bst_iterator_lagus_multiset_entry_##E##_finalize (iterator);\
+}
+
+/* Weighted BST */
+
+// Declaration
+
+# define lagus_declare_weighted_bst(E, W) \
+\
+lagus_declare_aggregate_bst(E, W)\
+\
+typedef lagus_aggregate_bst_##E lagus_weighted_bst_##E;\
+\
+lagus_result lagus_weighted_bst_##E##_initialize (lagus_weighted_bst_##E * tree);\
+\
+lagus_result lagus_weighted_bst_##E##_custom_initialize (lagus_weighted_bst_##E * tree, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_weighted_bst_##E##_finalize (lagus_weighted_bst_##E * tree);\
+\
+lagus_result lagus_weighted_bst_##E##_size (lagus_weighted_bst_##E * tree, uint64_t * size);\
+\
+lagus_result lagus_weighted_bst_##E##_total (lagus_weighted_bst_##E * tree, W * total);\
+\
+lagus_result lagus_weighted_bst_##E##_add (lagus_weighted_bst_##E * tree, E element);\
+\
+lagus_result lagus_weighted_bst_##E##_remove (lagus_weighted_bst_##E * tree, E * element);\
+\
+lagus_result lagus_weighted_bst_##E##_remove_at (lagus_weighted_bst_##E * tree, uint64_t index, E * element);\
+\
+lagus_result lagus_weighted_bst_##E##_set_at (lagus_weighted_bst_##E * tree, uint64_t index, E * element);\
+\
+lagus_result lagus_weighted_bst_##E##_sample (lagus_weighted_bst_##E * tree, W target, E * element, uint64_t * index);
+
+// Implementation
+
+# define lagus_implement_weighted_bst(E, W, F) \
+\
+static W lagus_weighted_bst_##E##_sum (W a, W b) {\
+    return a + b;\
+}\
+\
+lagus_implement_aggregate_bst(E, W, 0, F, lagus_weighted_bst_##E##_sum)\
+\
+lagus_result lagus_weighted_bst_##E##_initialize (lagus_weighted_bst_##E * tree) {\
+    return lagus_aggregate_bst_##E##_initialize (tree);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_custom_initialize (lagus_weighted_bst_##E * tree, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management) {\
+    return lagus_aggregate_bst_##E##_custom_initialize (tree, capacity, compare, memory_management);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_finalize (lagus_weighted_bst_##E * tree) {\
+    return lagus_aggregate_bst_##E##_finalize (tree);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_size (lagus_weighted_bst_##E * tree, uint64_t * size) {\
+    return lagus_aggregate_bst_##E##_size (tree, size);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_total (lagus_weighted_bst_##E * tree, W * total) {\
+    return lagus_aggregate_bst_##E##_aggregate (tree, total);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_add (lagus_weighted_bst_##E * tree, E element) {\
+    return lagus_aggregate_bst_##E##_add_right (tree, element);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_remove (lagus_weighted_bst_##E * tree, E * element) {\
+    return lagus_aggregate_bst_##E##_remove_left (tree, element);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_remove_at (lagus_weighted_bst_##E * tree, uint64_t index, E * element) {\
+    return lagus_aggregate_bst_##E##_remove_at (tree, index, element);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_set_at (lagus_weighted_bst_##E * tree, uint64_t index, E * element) {\
+    return lagus_aggregate_bst_##E##_set_at (tree, index, element);\
+}\
+\
+lagus_result lagus_weighted_bst_##E##_sample (lagus_weighted_bst_##E * tree, W target, E * element, uint64_t * index) {\
+    if (tree -> height == 0)\
+        return lagus_not_contained;\
+    uint64_t offset = 0;\
+    uint64_t node = lagus_root;\
+    while (node) {\
+        uint64_t left_child = tree -> buffer [node].left_child;\
+        if (left_child) {\
+            if (target < tree -> buffer [left_child].aggregate) {\
+                node = left_child;\
+                continue;\
+            }\
+            target -= tree -> buffer [left_child].aggregate;\
+            offset += tree -> buffer [left_child].size;\
+        }\
+        offset ++;\
+        W weight = F (tree -> buffer [node].element);\
+        if (target < weight) {\
+            * element = tree -> buffer [node].element;\
+            * index = offset;\
+            return lagus_success;\
+        }\
+        target -= weight;\
+        node = tree -> buffer [node].right_child;\
+    }\
+    return lagus_not_contained;\
+}
+
+/* Sequence */
+
+// Declaration
+
+# define lagus_declare_sequence(E, D) \
+\
+lagus_declare_bst_nodes(E, sequence, bool reversed; bool pending; D delta;)\
+\
+typedef struct lagus_sequence_##E {\
+    uint64_t height;\
+    uint64_t capacity;\
+    lagus_sequence_node_##E * buffer;\
+    lagus_memory_management memory_management;\
+} lagus_sequence_##E;\
+\
+typedef struct lagus_sequence_iterator_##E {\
+    __uint128_t index;\
+    uint64_t height;\
+    uint64_t node;\
+    lagus_sequence_node_##E * buffer;\
+} lagus_sequence_iterator_##E;\
+\
+lagus_result lagus_sequence_##E##_initialize (lagus_sequence_##E * sequence);\
+\
+lagus_result lagus_sequence_##E##_custom_initialize (lagus_sequence_##E * sequence, uint64_t capacity, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_sequence_##E##_finalize (lagus_sequence_##E * sequence);\
+\
+lagus_result lagus_sequence_##E##_size (lagus_sequence_##E * sequence, uint64_t * size);\
+\
+lagus_result lagus_sequence_##E##_add_at (lagus_sequence_##E * sequence, uint64_t index, E element);\
+\
+lagus_result lagus_sequence_##E##_add_array_at (lagus_sequence_##E * sequence, uint64_t index, E * elements, uint64_t size);\
+\
+lagus_result lagus_sequence_##E##_remove_at (lagus_sequence_##E * sequence, uint64_t index, E * element);\
+\
+lagus_result lagus_sequence_##E##_remove_range_at (lagus_sequence_##E * sequence, uint64_t first, uint64_t last, E * elements);\
+\
+lagus_result lagus_sequence_##E##_get_at (lagus_sequence_##E * sequence, uint64_t index, E * element);\
+\
+lagus_result lagus_sequence_##E##_set_at (lagus_sequence_##E * sequence, uint64_t index, E * element);\
+\
+lagus_result lagus_sequence_##E##_update_range_at (lagus_sequence_##E * sequence, uint64_t first, uint64_t last, D delta);\
+\
+lagus_result lagus_sequence_##E##_reverse_range_at (lagus_sequence_##E * sequence, uint64_t first, uint64_t last);\
+\
+lagus_result lagus_sequence_iterator_##E##_initialize (lagus_sequence_iterator_##E * iterator, lagus_sequence_##E * sequence);\
+\
+lagus_result lagus_sequence_iterator_##E##_next (lagus_sequence_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_sequence_iterator_##E##_finalize (lagus_sequence_iterator_##E * iterator);
+
+// Implementation
+
+# define lagus_implement_sequence(E, D, A, C) \
+\
+lagus_result lagus_sequence_##E##_initialize (lagus_sequence_##E * sequence) {\
+    return lagus_sequence_##E##_custom_initialize (sequence, 1, NULL);\
+}\
+\
+lagus_result lagus_sequence_##E##_custom_initialize (lagus_sequence_##E * sequence, uint64_t capacity, lagus_memory_management * memory_management) {\
+    if (! capacity)\
+        capacity = 1;\
+    if (memory_management)\
+        sequence -> memory_management = * memory_management;\
+    else\
+        sequence -> memory_management = (lagus_memory_management) {\
+            .allocate = aligned_alloc,\
+            .reallocate = realloc,\
+            .deallocate = free\
+        };\
+    lagus_sequence_node_##E * buffer = sequence -> memory_management.allocate (_Alignof (lagus_sequence_node_##E), capacity * sizeof (lagus_sequence_node_##E));\
+    if (! buffer)\
+        return lagus_memory_allocation;\
+    sequence -> height = 0;\
+    sequence -> capacity = capacity;\
+    sequence -> buffer = buffer - 1;\
+    * buffer = (lagus_sequence_node_##E) {\
+        .parent = lagus_none,\
+        .left_child = lagus_none,\
+        .right_child = lagus_none,\
+        .size = 0\
+    };\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_sequence_##E##_finalize (lagus_sequence_##E * sequence) {\
+    sequence -> memory_management.deallocate (sequence -> buffer + 1);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_sequence_##E##_size (lagus_sequence_##E * sequence, uint64_t * size) {\
+    * size = sequence -> buffer [lagus_root].size;\
+    return lagus_success;\
+}\
+\
+static void lagus_sequence_##E##_tag (lagus_sequence_node_##E * buffer, uint64_t node, D delta) {\
+    buffer [node].element = A (buffer [node].element, delta);\
+    if (buffer [node].pending)\
+        buffer [node].delta = C (buffer [node].delta, delta);\
+    else {\
+        buffer [node].delta = delta;\
+        buffer [node].pending = true;\
     }\
-    while (node != lagus_root) {\
-        node = bst -> buffer [node].parent;\
-        bst -> buffer [node].size --;\
+}\
+\
+static void lagus_sequence_##E##_propagate (lagus_sequence_node_##E * buffer, uint64_t node) {\
+    uint64_t left = buffer [node].left_child;\
+    uint64_t right = buffer [node].right_child;\
+    if (buffer [node].reversed) {\
+        buffer [node].left_child = right;\
+        buffer [node].right_child = left;\
+        if (buffer [node].configuration == 0b10)\
+            buffer [node].configuration = 0b01;\
+        else if (buffer [node].configuration == 0b01)\
+            buffer [node].configuration = 0b10;\
+        if (left)\
+            buffer [left].reversed = ! buffer [left].reversed;\
+        if (right)\
+            buffer [right].reversed = ! buffer [right].reversed;\
+        buffer [node].reversed = false;\
     }\
-    uint64_t capacity;\
-    if (bst -> capacity < 4)\
-        capacity = 1;\
-    else\
-        capacity = bst -> capacity >> 2;\
-    if (size <= capacity) {\
-        lagus_bst_node_##E * buffer = bst -> memory_management.reallocate (bst -> buffer + 1, capacity * sizeof (lagus_bst_node_##E));\
+    if (buffer [node].pending) {\
+        if (left)\
+            lagus_sequence_##E##_tag (buffer, left, buffer [node].delta);\
+        if (right)\
+            lagus_sequence_##E##_tag (buffer, right, buffer [node].delta);\
+        buffer [node].pending = false;\
+    }\
+}\
+\
+lagus_implement_bst_nodes(E, sequence, lagus_bst_no_update, lagus_sequence_##E##_propagate)\
+\
+static void lagus_sequence_##E##_settle (lagus_sequence_##E * sequence, uint64_t root, uint64_t height) {\
+    sequence -> height = height;\
+    if (! root) {\
+        sequence -> buffer [lagus_root] = (lagus_sequence_node_##E) {\
+            .parent = lagus_none,\
+            .left_child = lagus_none,\
+            .right_child = lagus_none,\
+            .size = 0\
+        };\
+        return;\
+    }\
+    sequence -> buffer [root].parent = lagus_none;\
+    if (root != lagus_root)\
+        lagus_sequence_##E##_swap_nodes (sequence -> buffer, lagus_root, root);\
+}\
+\
+lagus_result lagus_sequence_##E##_add_array_at (lagus_sequence_##E * sequence, uint64_t index, E * elements, uint64_t size) {\
+    if (! size)\
+        return lagus_success;\
+    uint64_t total = sequence -> buffer [lagus_root].size;\
+    if (total + size > sequence -> capacity) {\
+        uint64_t capacity = sequence -> capacity;\
+        while (capacity < total + size)\
+            capacity <<= 1;\
+        lagus_sequence_node_##E * buffer = sequence -> memory_management.reallocate (sequence -> buffer + 1, capacity * sizeof (lagus_sequence_node_##E));\
         if (! buffer)\
             return lagus_memory_allocation;\
-        bst -> capacity = capacity;\
-        bst -> buffer = buffer - 1;\
+        sequence -> capacity = capacity;\
+        sequence -> buffer = buffer - 1;\
     }\
+    uint64_t middle = total + 1;\
+    uint64_t middle_height = lagus_sequence_##E##_balanced_height (size);\
+    lagus_sequence_##E##_build_subtree (sequence -> buffer, elements, size, middle, lagus_none);\
+    uint64_t root = lagus_none;\
+    if (total)\
+        root = lagus_root;\
+    uint64_t left, left_height, right, right_height, height;\
+    lagus_sequence_##E##_split_count (sequence -> buffer, root, sequence -> height, index - 1, & left, & left_height, & right, & right_height);\
+    root = lagus_sequence_##E##_join_pair (sequence -> buffer, left, left_height, middle, middle_height, & height);\
+    root = lagus_sequence_##E##_join_pair (sequence -> buffer, root, height, right, right_height, & height);\
+    lagus_sequence_##E##_settle (sequence, root, height);\
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_get_at (lagus_bst_##E * bst, uint64_t index, E * element) {\
-    uint64_t node = lagus_root;\
-    while (true) {\
-        uint64_t left_child = bst -> buffer [node].left_child;\
-        uint64_t size;\
-        if (left_child)\
-            size = bst -> buffer [left_child].size;\
-        else\
-            size = 0;\
-        if (index == size + 1) {\
-            * element = bst -> buffer [node].element;\
-            return lagus_success;\
-        }\
-        if (index <= size)\
-            node = left_child;\
-        else {\
-            index -= size + 1;\
-            node = bst -> buffer [node].right_child;\
-        }\
+lagus_result lagus_sequence_##E##_add_at (lagus_sequence_##E * sequence, uint64_t index, E element) {\
+    return lagus_sequence_##E##_add_array_at (sequence, index, & element, 1);\
+}\
+\
+lagus_result lagus_sequence_##E##_remove_range_at (lagus_sequence_##E * sequence, uint64_t first, uint64_t last, E * elements) {\
+    if (first == 0)\
+        return lagus_not_contained;\
+    if (sequence -> height == 0)\
+        return lagus_success;\
+    if (last > sequence -> buffer [lagus_root].size)\
+        last = sequence -> buffer [lagus_root].size;\
+    if (last < first)\
+        return lagus_success;\
+    uint64_t size = sequence -> buffer [lagus_root].size;\
+    uint64_t left, left_height, middle, middle_height, right, right_height, height;\
+    lagus_sequence_##E##_split_count (sequence -> buffer, lagus_root, sequence -> height, first - 1, & left, & left_height, & right, & right_height);\
+    lagus_sequence_##E##_split_count (sequence -> buffer, right, right_height, last - first + 1, & middle, & middle_height, & right, & right_height);\
+    uint64_t removed = 0;\
+    if (middle)\
+        removed = sequence -> buffer [middle].size;\
+    if (elements)\
+        lagus_sequence_##E##_flatten (sequence -> buffer, middle, elements);\
+    lagus_sequence_##E##_release (sequence -> buffer, middle);\
+    uint64_t root = lagus_sequence_##E##_join_pair (sequence -> buffer, left, left_height, right, right_height, & height);\
+    sequence -> height = height;\
+    if (root) {\
+        sequence -> buffer [root].parent = lagus_none;\
+        lagus_sequence_##E##_compact (sequence -> buffer, root, size, size - removed);\
+    } else\
+        lagus_sequence_##E##_settle (sequence, root, height);\
+    size -= removed;\
+    uint64_t capacity = sequence -> capacity;\
+    while (capacity >= 4 && size <= capacity >> 2)\
+        capacity >>= 2;\
+    if (capacity < sequence -> capacity) {\
+        lagus_sequence_node_##E * buffer = sequence -> memory_management.reallocate (sequence -> buffer + 1, capacity * sizeof (lagus_sequence_node_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        sequence -> capacity = capacity;\
+        sequence -> buffer = buffer - 1;\
     }\
+    return lagus_success;\
 }\
 \
-lagus_result lagus_bst_##E##_set_at (lagus_bst_##E * bst, uint64_t index, E * element) {\
+lagus_result lagus_sequence_##E##_remove_at (lagus_sequence_##E * sequence, uint64_t index, E * element) {\
+    return lagus_sequence_##E##_remove_range_at (sequence, index, index, element);\
+}\
+\
+static uint64_t lagus_sequence_##E##_locate (lagus_sequence_##E * sequence, uint64_t index) {\
     uint64_t node = lagus_root;\
     while (true) {\
-        uint64_t left_child = bst -> buffer [node].left_child;\
+        lagus_sequence_##E##_propagate (sequence -> buffer, node);\
+        uint64_t left_child = sequence -> buffer [node].left_child;\
         uint64_t size;\
         if (left_child)\
-            size = bst -> buffer [left_child].size;\
+            size = sequence -> buffer [left_child].size;\
         else\
             size = 0;\
-        if (index == size + 1) {\
-            E temporal = bst -> buffer [node].element;\
-            bst -> buffer [node].element = * element;\
-            * element = temporal;\
-            return lagus_success;\
-        }\
+        if (index == size + 1)\
+            return node;\
         if (index <= size)\
             node = left_child;\
         else {\
             index -= size + 1;\
-            node = bst -> buffer [node].right_child;\
+            node = sequence -> buffer [node].right_child;\
         }\
     }\
 }\
 \
-lagus_result lagus_bst_iterator_##E##_initialize (lagus_bst_iterator_##E * iterator, lagus_bst_##E * bst) {\
-    if (bst -> height) {\
-        * iterator = (lagus_bst_iterator_##E) {\
-            .height = bst -> height,\
+lagus_result lagus_sequence_##E##_get_at (lagus_sequence_##E * sequence, uint64_t index, E * element) {\
+    * element = sequence -> buffer [lagus_sequence_##E##_locate (sequence, index)].element;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_sequence_##E##_set_at (lagus_sequence_##E * sequence, uint64_t index, E * element) {\
+    uint64_t node = lagus_sequence_##E##_locate (sequence, index);\
+    E temporal = sequence -> buffer [node].element;\
+    sequence -> buffer [node].element = * element;\
+    * element = temporal;\
+    return lagus_success;\
+}\
+\
+static void lagus_sequence_##E##_range (lagus_sequence_##E * sequence, uint64_t first, uint64_t last, D * delta) {\
+    uint64_t left, left_height, middle, middle_height, right, right_height, height;\
+    lagus_sequence_##E##_split_count (sequence -> buffer, lagus_root, sequence -> height, first - 1, & left, & left_height, & right, & right_height);\
+    lagus_sequence_##E##_split_count (sequence -> buffer, right, right_height, last - first + 1, & middle, & middle_height, & right, & right_height);\
+    if (delta)\
+        lagus_sequence_##E##_tag (sequence -> buffer, middle, * delta);\
+    else\
+        sequence -> buffer [middle].reversed = ! sequence -> buffer [middle].reversed;\
+    uint64_t root = lagus_sequence_##E##_join_pair (sequence -> buffer, left, left_height, middle, middle_height, & height);\
+    root = lagus_sequence_##E##_join_pair (sequence -> buffer, root, height, right, right_height, & height);\
+    lagus_sequence_##E##_settle (sequence, root, height);\
+}\
+\
+lagus_result lagus_sequence_##E##_update_range_at (lagus_sequence_##E * sequence, uint64_t first, uint64_t last, D delta) {\
+    if (first == 0)\
+        return lagus_not_contained;\
+    if (sequence -> height == 0)\
+        return lagus_success;\
+    if (last > sequence -> buffer [lagus_root].size)\
+        last = sequence -> buffer [lagus_root].size;\
+    if (last < first)\
+        return lagus_success;\
+    lagus_sequence_##E##_range (sequence, first, last, & delta);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_sequence_##E##_reverse_range_at (lagus_sequence_##E * sequence, uint64_t first, uint64_t last) {\
+    if (first == 0)\
+        return lagus_not_contained;\
+    if (sequence -> height == 0)\
+        return lagus_success;\
+    if (last > sequence -> buffer [lagus_root].size)\
+        last = sequence -> buffer [lagus_root].size;\
+    if (last <= first)\
+        return lagus_success;\
+    lagus_sequence_##E##_range (sequence, first, last, NULL);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_sequence_iterator_##E##_initialize (lagus_sequence_iterator_##E * iterator, lagus_sequence_##E * sequence) {\
+    if (sequence -> height) {\
+        * iterator = (lagus_sequence_iterator_##E) {\
+            .height = sequence -> height,\
             .node = lagus_root,\
-            .buffer = bst -> buffer\
+            .buffer = sequence -> buffer\
         };\
         while (true) {\
-            uint64_t child = bst -> buffer [iterator -> node].left_child;\
+            lagus_sequence_##E##_propagate (sequence -> buffer, iterator -> node);\
+            uint64_t child = sequence -> buffer [iterator -> node].left_child;\
             if (! child)\
                 break;\
             iterator -> height --;\
@@ -2899,7 +6406,7 @@ lagus_result lagus_bst_iterator_##E##_initialize (lagus_bst_iterator_##E * itera
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_iterator_##E##_next (lagus_bst_iterator_##E * iterator, E * element) {\
+lagus_result lagus_sequence_iterator_##E##_next (lagus_sequence_iterator_##E * iterator, E * element) {\
     if (! iterator -> node)\
         return lagus_stop;\
     * element = iterator -> buffer [iterator -> node].element;\
@@ -2909,6 +6416,7 @@ lagus_result lagus_bst_iterator_##E##_next (lagus_bst_iterator_##E * iterator, E
         iterator -> index += lagus_one << iterator -> height - 1;\
         while (true) {\
             iterator -> node = child;\
+            lagus_sequence_##E##_propagate (iterator -> buffer, iterator -> node);\
             child = iterator -> buffer [iterator -> node].left_child;\
             if (! child)\
                 break;\
@@ -2956,7 +6464,594 @@ lagus_result lagus_bst_iterator_##E##_next (lagus_bst_iterator_##E * iterator, E
     return lagus_success;\
 }\
 \
-lagus_result lagus_bst_iterator_##E##_finalize (lagus_bst_iterator_##E * iterator) {\
+lagus_result lagus_sequence_iterator_##E##_finalize (lagus_sequence_iterator_##E * iterator) {\
+    return lagus_success;\
+}
+
+/* B-tree */
+
+# define lagus_btree_leaf_capacity(E) (sizeof (E) < 64 ? 256 / sizeof (E) : 4)
+# define lagus_btree_branch_capacity(E) (sizeof (E) < 112 ? 512 / (16 + sizeof (E)) : 4)
+
+// Declaration
+
+# define lagus_declare_btree(E) \
+\
+typedef int64_t (* lagus_compare_##E) (E, E);\
+\
+typedef struct lagus_btree_leaf_##E {\
+    uint64_t next;\
+    uint64_t count;\
+    E elements [lagus_btree_leaf_capacity (E)];\
+} lagus_btree_leaf_##E;\
+\
+typedef struct lagus_btree_branch_##E {\
+    uint64_t count;\
+    uint64_t children [lagus_btree_branch_capacity (E)];\
+    uint64_t sizes [lagus_btree_branch_capacity (E)];\
+    E keys [lagus_btree_branch_capacity (E) - 1];\
+} lagus_btree_branch_##E;\
+\
+typedef struct lagus_btree_##E {\
+    uint64_t height;\
+    uint64_t size;\
+    uint64_t root;\
+    uint64_t first;\
+    uint64_t leaves_capacity;\
+    uint64_t leaves_size;\
+    uint64_t free_leaves;\
+    uint64_t branches_capacity;\
+    uint64_t branches_size;\
+    uint64_t free_branches;\
+    lagus_btree_leaf_##E * leaves;\
+    lagus_btree_branch_##E * branches;\
+    lagus_compare_##E compare;\
+    lagus_memory_management memory_management;\
+} lagus_btree_##E;\
+\
+typedef struct lagus_btree_iterator_##E {\
+    uint64_t leaf;\
+    uint64_t position;\
+    lagus_btree_leaf_##E * leaves;\
+} lagus_btree_iterator_##E;\
+\
+lagus_result lagus_btree_##E##_initialize (lagus_btree_##E * btree);\
+\
+lagus_result lagus_btree_##E##_custom_initialize (lagus_btree_##E * btree, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management);\
+\
+lagus_result lagus_btree_##E##_finalize (lagus_btree_##E * btree);\
+\
+lagus_result lagus_btree_##E##_size (lagus_btree_##E * btree, uint64_t * size);\
+\
+lagus_result lagus_btree_##E##_add_left (lagus_btree_##E * btree, E element);\
+\
+lagus_result lagus_btree_##E##_add_right (lagus_btree_##E * btree, E element);\
+\
+lagus_result lagus_btree_##E##_search_left (lagus_btree_##E * btree, E * element, uint64_t * index);\
+\
+lagus_result lagus_btree_##E##_search_right (lagus_btree_##E * btree, E * element, uint64_t * index);\
+\
+lagus_result lagus_btree_##E##_remove_left (lagus_btree_##E * btree, E * element);\
+\
+lagus_result lagus_btree_##E##_remove_right (lagus_btree_##E * btree, E * element);\
+\
+lagus_result lagus_btree_##E##_remove_at (lagus_btree_##E * btree, uint64_t index, E * element);\
+\
+lagus_result lagus_btree_##E##_get_at (lagus_btree_##E * btree, uint64_t index, E * element);\
+\
+lagus_result lagus_btree_iterator_##E##_initialize (lagus_btree_iterator_##E * iterator, lagus_btree_##E * btree);\
+\
+lagus_result lagus_btree_iterator_##E##_next (lagus_btree_iterator_##E * iterator, E * element);\
+\
+lagus_result lagus_btree_iterator_##E##_finalize (lagus_btree_iterator_##E * iterator);
+
+// Implementation
+
+# define lagus_implement_btree(E) \
+\
+static int64_t lagus_btree_##E##_binary_compare (E a, E b) {\
+    return lagus_binary_compare ((uint8_t *) & a, (uint8_t *) & b, sizeof (E));\
+}\
+\
+lagus_result lagus_btree_##E##_initialize (lagus_btree_##E * btree) {\
+    return lagus_btree_##E##_custom_initialize (btree, 0, NULL, NULL);\
+}\
+\
+lagus_result lagus_btree_##E##_custom_initialize (lagus_btree_##E * btree, uint64_t capacity, lagus_compare_##E compare, lagus_memory_management * memory_management) {\
+    if (memory_management)\
+        btree -> memory_management = * memory_management;\
+    else\
+        btree -> memory_management = (lagus_memory_management) {\
+            .allocate = aligned_alloc,\
+            .reallocate = realloc,\
+            .deallocate = free\
+        };\
+    uint64_t leaves_capacity = capacity / lagus_btree_leaf_capacity (E) + 1;\
+    uint64_t branches_capacity = leaves_capacity / (lagus_btree_branch_capacity (E) >> 1) + 1;\
+    lagus_btree_leaf_##E * leaves = btree -> memory_management.allocate (_Alignof (lagus_btree_leaf_##E), leaves_capacity * sizeof (lagus_btree_leaf_##E));\
+    if (! leaves)\
+        return lagus_memory_allocation;\
+    lagus_btree_branch_##E * branches = btree -> memory_management.allocate (_Alignof (lagus_btree_branch_##E), branches_capacity * sizeof (lagus_btree_branch_##E));\
+    if (! branches) {\
+        btree -> memory_management.deallocate (leaves);\
+        return lagus_memory_allocation;\
+    }\
+    btree -> height = 0;\
+    btree -> size = 0;\
+    btree -> root = lagus_none;\
+    btree -> first = lagus_none;\
+    btree -> leaves_capacity = leaves_capacity;\
+    btree -> leaves_size = 0;\
+    btree -> free_leaves = lagus_none;\
+    btree -> branches_capacity = branches_capacity;\
+    btree -> branches_size = 0;\
+    btree -> free_branches = lagus_none;\
+    btree -> leaves = leaves - 1;\
+    btree -> branches = branches - 1;\
+    if (compare)\
+        btree -> compare = compare;\
+    else\
+        btree -> compare = lagus_btree_##E##_binary_compare;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_btree_##E##_finalize (lagus_btree_##E * btree) {\
+    btree -> memory_management.deallocate (btree -> leaves + 1);\
+    btree -> memory_management.deallocate (btree -> branches + 1);\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_btree_##E##_size (lagus_btree_##E * btree, uint64_t * size) {\
+    * size = btree -> size;\
+    return lagus_success;\
+}\
+\
+static lagus_result lagus_btree_##E##_reserve (lagus_btree_##E * btree, uint64_t leaves, uint64_t branches) {\
+    if (btree -> leaves_size + leaves > btree -> leaves_capacity) {\
+        uint64_t capacity = btree -> leaves_capacity;\
+        while (capacity < btree -> leaves_size + leaves)\
+            capacity <<= 1;\
+        lagus_btree_leaf_##E * buffer = btree -> memory_management.reallocate (btree -> leaves + 1, capacity * sizeof (lagus_btree_leaf_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        btree -> leaves_capacity = capacity;\
+        btree -> leaves = buffer - 1;\
+    }\
+    if (btree -> branches_size + branches > btree -> branches_capacity) {\
+        uint64_t capacity = btree -> branches_capacity;\
+        while (capacity < btree -> branches_size + branches)\
+            capacity <<= 1;\
+        lagus_btree_branch_##E * buffer = btree -> memory_management.reallocate (btree -> branches + 1, capacity * sizeof (lagus_btree_branch_##E));\
+        if (! buffer)\
+            return lagus_memory_allocation;\
+        btree -> branches_capacity = capacity;\
+        btree -> branches = buffer - 1;\
+    }\
+    return lagus_success;\
+}\
+\
+static uint64_t lagus_btree_##E##_new_leaf (lagus_btree_##E * btree) {\
+    uint64_t leaf = btree -> free_leaves;\
+    if (leaf)\
+        btree -> free_leaves = btree -> leaves [leaf].next;\
+    else\
+        leaf = ++ btree -> leaves_size;\
+    return leaf;\
+}\
+\
+static void lagus_btree_##E##_delete_leaf (lagus_btree_##E * btree, uint64_t leaf) {\
+    btree -> leaves [leaf].next = btree -> free_leaves;\
+    btree -> free_leaves = leaf;\
+}\
+\
+static uint64_t lagus_btree_##E##_new_branch (lagus_btree_##E * btree) {\
+    uint64_t branch = btree -> free_branches;\
+    if (branch)\
+        btree -> free_branches = btree -> branches [branch].children [0];\
+    else\
+        branch = ++ btree -> branches_size;\
+    return branch;\
+}\
+\
+static void lagus_btree_##E##_delete_branch (lagus_btree_##E * btree, uint64_t branch) {\
+    btree -> branches [branch].children [0] = btree -> free_branches;\
+    btree -> free_branches = branch;\
+}\
+\
+static uint64_t lagus_btree_##E##_bound (lagus_btree_##E * btree, E * keys, uint64_t count, E * element, bool inclusive) {\
+    if (! count)\
+        return 0;\
+    int64_t threshold = inclusive;\
+    uint64_t low = 0;\
+    while (count > 1) {\
+        uint64_t half = count >> 1;\
+        low += (btree -> compare (keys [low + half], * element) < threshold) * half;\
+        count -= half;\
+    }\
+    return low + (btree -> compare (keys [low], * element) < threshold);\
+}\
+\
+static uint64_t lagus_btree_##E##_rank (lagus_btree_##E * btree, E * element, bool inclusive) {\
+    if (btree -> height == 0)\
+        return 0;\
+    uint64_t count = 0;\
+    uint64_t node = btree -> root;\
+    for (uint64_t level = btree -> height; level > 1; level --) {\
+        lagus_btree_branch_##E * branch = btree -> branches + node;\
+        uint64_t position = lagus_btree_##E##_bound (btree, branch -> keys, branch -> count - 1, element, inclusive);\
+        for (uint64_t index = 0; index < position; index ++)\
+            count += branch -> sizes [index];\
+        node = branch -> children [position];\
+    }\
+    return count + lagus_btree_##E##_bound (btree, btree -> leaves [node].elements, btree -> leaves [node].count, element, inclusive);\
+}\
+\
+static uint64_t lagus_btree_##E##_locate (lagus_btree_##E * btree, uint64_t index, uint64_t * path, uint64_t * positions) {\
+    uint64_t node = btree -> root;\
+    for (uint64_t level = btree -> height; level > 1; level --) {\
+        lagus_btree_branch_##E * branch = btree -> branches + node;\
+        uint64_t position = 0;\
+        while (index > branch -> sizes [position]) {\
+            index -= branch -> sizes [position];\
+            position ++;\
+        }\
+        path [level] = node;\
+        positions [level] = position;\
+        node = branch -> children [position];\
+    }\
+    positions [1] = index - 1;\
+    return node;\
+}\
+\
+static lagus_result lagus_btree_##E##_add (lagus_btree_##E * btree, E element, bool inclusive) {\
+    if (lagus_btree_##E##_reserve (btree, 1, btree -> height))\
+        return lagus_memory_allocation;\
+    btree -> size ++;\
+    if (btree -> height == 0) {\
+        uint64_t leaf = lagus_btree_##E##_new_leaf (btree);\
+        btree -> leaves [leaf].next = lagus_none;\
+        btree -> leaves [leaf].count = 1;\
+        btree -> leaves [leaf].elements [0] = element;\
+        btree -> height = 1;\
+        btree -> root = leaf;\
+        btree -> first = leaf;\
+        return lagus_success;\
+    }\
+    uint64_t path [64];\
+    uint64_t positions [64];\
+    uint64_t node = btree -> root;\
+    for (uint64_t level = btree -> height; level > 1; level --) {\
+        lagus_btree_branch_##E * branch = btree -> branches + node;\
+        path [level] = node;\
+        positions [level] = lagus_btree_##E##_bound (btree, branch -> keys, branch -> count - 1, & element, inclusive);\
+        node = branch -> children [positions [level]];\
+    }\
+    lagus_btree_leaf_##E * leaf = btree -> leaves + node;\
+    uint64_t position = lagus_btree_##E##_bound (btree, leaf -> elements, leaf -> count, & element, inclusive);\
+    uint64_t right = lagus_none;\
+    uint64_t left_size, right_size;\
+    E separator;\
+    if (leaf -> count < lagus_btree_leaf_capacity (E)) {\
+        for (uint64_t index = leaf -> count; index > position; index --)\
+            leaf -> elements [index] = leaf -> elements [index - 1];\
+        leaf -> elements [position] = element;\
+        leaf -> count ++;\
+    } else {\
+        right = lagus_btree_##E##_new_leaf (btree);\
+        lagus_btree_leaf_##E * other = btree -> leaves + right;\
+        uint64_t half = lagus_btree_leaf_capacity (E) + 1 >> 1;\
+        if (position < half) {\
+            for (uint64_t index = half - 1; index < lagus_btree_leaf_capacity (E); index ++)\
+                other -> elements [index - half + 1] = leaf -> elements [index];\
+            for (uint64_t index = half - 1; index > position; index --)\
+                leaf -> elements [index] = leaf -> elements [index - 1];\
+            leaf -> elements [position] = element;\
+        } else {\
+            for (uint64_t index = half; index < position; index ++)\
+                other -> elements [index - half] = leaf -> elements [index];\
+            other -> elements [position - half] = element;\
+            for (uint64_t index = position; index < lagus_btree_leaf_capacity (E); index ++)\
+                other -> elements [index - half + 1] = leaf -> elements [index];\
+        }\
+        leaf -> count = half;\
+        other -> count = lagus_btree_leaf_capacity (E) + 1 - half;\
+        other -> next = leaf -> next;\
+        leaf -> next = right;\
+        separator = other -> elements [0];\
+        left_size = leaf -> count;\
+        right_size = other -> count;\
+    }\
+    for (uint64_t level = 2; level <= btree -> height; level ++) {\
+        lagus_btree_branch_##E * branch = btree -> branches + path [level];\
+        position = positions [level];\
+        if (! right) {\
+            branch -> sizes [position] ++;\
+            continue;\
+        }\
+        branch -> sizes [position] = left_size;\
+        if (branch -> count < lagus_btree_branch_capacity (E)) {\
+            for (uint64_t index = branch -> count; index > position + 1; index --) {\
+                branch -> children [index] = branch -> children [index - 1];\
+                branch -> sizes [index] = branch -> sizes [index - 1];\
+                branch -> keys [index - 1] = branch -> keys [index - 2];\
+            }\
+            branch -> children [position + 1] = right;\
+            branch -> sizes [position + 1] = right_size;\
+            branch -> keys [position] = separator;\
+            branch -> count ++;\
+            right = lagus_none;\
+            continue;\
+        }\
+        uint64_t children [lagus_btree_branch_capacity (E) + 1];\
+        uint64_t sizes [lagus_btree_branch_capacity (E) + 1];\
+        E keys [lagus_btree_branch_capacity (E)];\
+        for (uint64_t index = 0, source = 0; index <= lagus_btree_branch_capacity (E); index ++) {\
+            if (index == position + 1) {\
+                children [index] = right;\
+                sizes [index] = right_size;\
+                keys [index - 1] = separator;\
+                continue;\
+            }\
+            children [index] = branch -> children [source];\
+            sizes [index] = branch -> sizes [source];\
+            if (index)\
+                keys [index - 1] = branch -> keys [source - 1];\
+            source ++;\
+        }\
+        right = lagus_btree_##E##_new_branch (btree);\
+        lagus_btree_branch_##E * other = btree -> branches + right;\
+        uint64_t half = lagus_btree_branch_capacity (E) + 1 >> 1;\
+        branch -> count = half;\
+        other -> count = lagus_btree_branch_capacity (E) + 1 - half;\
+        left_size = 0;\
+        right_size = 0;\
+        for (uint64_t index = 0; index < half; index ++) {\
+            branch -> children [index] = children [index];\
+            branch -> sizes [index] = sizes [index];\
+            left_size += sizes [index];\
+            if (index)\
+                branch -> keys [index - 1] = keys [index - 1];\
+        }\
+        for (uint64_t index = half; index <= lagus_btree_branch_capacity (E); index ++) {\
+            other -> children [index - half] = children [index];\
+            other -> sizes [index - half] = sizes [index];\
+            right_size += sizes [index];\
+            if (index > half)\
+                other -> keys [index - half - 1] = keys [index - 1];\
+        }\
+        separator = keys [half - 1];\
+    }\
+    if (right) {\
+        uint64_t root = lagus_btree_##E##_new_branch (btree);\
+        lagus_btree_branch_##E * branch = btree -> branches + root;\
+        branch -> count = 2;\
+        branch -> children [0] = btree -> root;\
+        branch -> children [1] = right;\
+        branch -> sizes [0] = left_size;\
+        branch -> sizes [1] = right_size;\
+        branch -> keys [0] = separator;\
+        btree -> root = root;\
+        btree -> height ++;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_btree_##E##_add_left (lagus_btree_##E * btree, E element) {\
+    return lagus_btree_##E##_add (btree, element, false);\
+}\
+\
+lagus_result lagus_btree_##E##_add_right (lagus_btree_##E * btree, E element) {\
+    return lagus_btree_##E##_add (btree, element, true);\
+}\
+\
+lagus_result lagus_btree_##E##_search_left (lagus_btree_##E * btree, E * element, uint64_t * index) {\
+    uint64_t rank = lagus_btree_##E##_rank (btree, element, false);\
+    if (rank == btree -> size)\
+        return lagus_not_contained;\
+    uint64_t path [64];\
+    uint64_t positions [64];\
+    uint64_t leaf = lagus_btree_##E##_locate (btree, rank + 1, path, positions);\
+    E * match = btree -> leaves [leaf].elements + positions [1];\
+    if (btree -> compare (* element, * match))\
+        return lagus_not_contained;\
+    * element = * match;\
+    * index = rank + 1;\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_btree_##E##_search_right (lagus_btree_##E * btree, E * element, uint64_t * index) {\
+    uint64_t rank = lagus_btree_##E##_rank (btree, element, true);\
+    if (rank == 0)\
+        return lagus_not_contained;\
+    uint64_t path [64];\
+    uint64_t positions [64];\
+    uint64_t leaf = lagus_btree_##E##_locate (btree, rank, path, positions);\
+    E * match = btree -> leaves [leaf].elements + positions [1];\
+    if (btree -> compare (* element, * match))\
+        return lagus_not_contained;\
+    * element = * match;\
+    * index = rank;\
+    return lagus_success;\
+}\
+\
+static void lagus_btree_##E##_erase (lagus_btree_branch_##E * branch, uint64_t position) {\
+    for (uint64_t index = position; index + 1 < branch -> count; index ++) {\
+        branch -> children [index] = branch -> children [index + 1];\
+        branch -> sizes [index] = branch -> sizes [index + 1];\
+        branch -> keys [index - 1] = branch -> keys [index];\
+    }\
+    branch -> count --;\
+}\
+\
+static void lagus_btree_##E##_rebalance_leaves (lagus_btree_##E * btree, lagus_btree_branch_##E * branch, uint64_t position, bool borrow) {\
+    lagus_btree_leaf_##E * left = btree -> leaves + branch -> children [position];\
+    lagus_btree_leaf_##E * right = btree -> leaves + branch -> children [position + 1];\
+    if (! borrow) {\
+        for (uint64_t index = 0; index < right -> count; index ++)\
+            left -> elements [left -> count + index] = right -> elements [index];\
+        left -> count += right -> count;\
+        left -> next = right -> next;\
+        lagus_btree_##E##_delete_leaf (btree, branch -> children [position + 1]);\
+        branch -> sizes [position] += branch -> sizes [position + 1];\
+        lagus_btree_##E##_erase (branch, position + 1);\
+    } else if (left -> count < right -> count) {\
+        left -> elements [left -> count] = right -> elements [0];\
+        left -> count ++;\
+        right -> count --;\
+        for (uint64_t index = 0; index < right -> count; index ++)\
+            right -> elements [index] = right -> elements [index + 1];\
+        branch -> keys [position] = right -> elements [0];\
+        branch -> sizes [position] ++;\
+        branch -> sizes [position + 1] --;\
+    } else {\
+        for (uint64_t index = right -> count; index > 0; index --)\
+            right -> elements [index] = right -> elements [index - 1];\
+        right -> elements [0] = left -> elements [left -> count - 1];\
+        left -> count --;\
+        right -> count ++;\
+        branch -> keys [position] = right -> elements [0];\
+        branch -> sizes [position] --;\
+        branch -> sizes [position + 1] ++;\
+    }\
+}\
+\
+static void lagus_btree_##E##_rebalance_branches (lagus_btree_##E * btree, lagus_btree_branch_##E * branch, uint64_t position, bool borrow) {\
+    lagus_btree_branch_##E * left = btree -> branches + branch -> children [position];\
+    lagus_btree_branch_##E * right = btree -> branches + branch -> children [position + 1];\
+    if (! borrow) {\
+        left -> keys [left -> count - 1] = branch -> keys [position];\
+        for (uint64_t index = 0; index < right -> count; index ++) {\
+            left -> children [left -> count + index] = right -> children [index];\
+            left -> sizes [left -> count + index] = right -> sizes [index];\
+            if (index)\
+                left -> keys [left -> count + index - 1] = right -> keys [index - 1];\
+        }\
+        left -> count += right -> count;\
+        lagus_btree_##E##_delete_branch (btree, branch -> children [position + 1]);\
+        branch -> sizes [position] += branch -> sizes [position + 1];\
+        lagus_btree_##E##_erase (branch, position + 1);\
+    } else if (left -> count < right -> count) {\
+        uint64_t moved = right -> sizes [0];\
+        left -> children [left -> count] = right -> children [0];\
+        left -> sizes [left -> count] = moved;\
+        left -> keys [left -> count - 1] = branch -> keys [position];\
+        branch -> keys [position] = right -> keys [0];\
+        left -> count ++;\
+        right -> count --;\
+        for (uint64_t index = 0; index < right -> count; index ++) {\
+            right -> children [index] = right -> children [index + 1];\
+            right -> sizes [index] = right -> sizes [index + 1];\
+            if (index + 1 < right -> count)\
+                right -> keys [index] = right -> keys [index + 1];\
+        }\
+        branch -> sizes [position] += moved;\
+        branch -> sizes [position + 1] -= moved;\
+    } else {\
+        uint64_t moved = left -> sizes [left -> count - 1];\
+        for (uint64_t index = right -> count; index > 0; index --) {\
+            right -> children [index] = right -> children [index - 1];\
+            right -> sizes [index] = right -> sizes [index - 1];\
+            if (index > 1)\
+                right -> keys [index - 1] = right -> keys [index - 2];\
+        }\
+        right -> children [0] = left -> children [left -> count - 1];\
+        right -> sizes [0] = moved;\
+        right -> keys [0] = branch -> keys [position];\
+        branch -> keys [position] = left -> keys [left -> count - 2];\
+        left -> count --;\
+        right -> count ++;\
+        branch -> sizes [position] -= moved;\
+        branch -> sizes [position + 1] += moved;\
+    }\
+}\
+\
+lagus_result lagus_btree_##E##_remove_at (lagus_btree_##E * btree, uint64_t index, E * element) {\
+    uint64_t path [64];\
+    uint64_t positions [64];\
+    uint64_t node = lagus_btree_##E##_locate (btree, index, path, positions);\
+    lagus_btree_leaf_##E * leaf = btree -> leaves + node;\
+    * element = leaf -> elements [positions [1]];\
+    leaf -> count --;\
+    for (uint64_t position = positions [1]; position < leaf -> count; position ++)\
+        leaf -> elements [position] = leaf -> elements [position + 1];\
+    btree -> size --;\
+    bool underflow = leaf -> count < lagus_btree_leaf_capacity (E) >> 1;\
+    for (uint64_t level = 2; level <= btree -> height; level ++) {\
+        lagus_btree_branch_##E * branch = btree -> branches + path [level];\
+        uint64_t position = positions [level];\
+        branch -> sizes [position] --;\
+        if (! underflow)\
+            continue;\
+        if (position)\
+            position --;\
+        if (level == 2) {\
+            uint64_t count = btree -> leaves [branch -> children [position]].count + btree -> leaves [branch -> children [position + 1]].count;\
+            lagus_btree_##E##_rebalance_leaves (btree, branch, position, count > lagus_btree_leaf_capacity (E));\
+        } else {\
+            uint64_t count = btree -> branches [branch -> children [position]].count + btree -> branches [branch -> children [position + 1]].count;\
+            lagus_btree_##E##_rebalance_branches (btree, branch, position, count > lagus_btree_branch_capacity (E));\
+        }\
+        underflow = branch -> count < lagus_btree_branch_capacity (E) >> 1;\
+    }\
+    if (btree -> height > 1 && btree -> branches [btree -> root].count == 1) {\
+        node = btree -> root;\
+        btree -> root = btree -> branches [node].children [0];\
+        lagus_btree_##E##_delete_branch (btree, node);\
+        btree -> height --;\
+    } else if (btree -> height == 1 && btree -> size == 0) {\
+        lagus_btree_##E##_delete_leaf (btree, btree -> root);\
+        btree -> height = 0;\
+        btree -> root = lagus_none;\
+        btree -> first = lagus_none;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_btree_##E##_remove_left (lagus_btree_##E * btree, E * element) {\
+    uint64_t index;\
+    if (lagus_btree_##E##_search_left (btree, element, & index))\
+        return lagus_not_contained;\
+    return lagus_btree_##E##_remove_at (btree, index, element);\
+}\
+\
+lagus_result lagus_btree_##E##_remove_right (lagus_btree_##E * btree, E * element) {\
+    uint64_t index;\
+    if (lagus_btree_##E##_search_right (btree, element, & index))\
+        return lagus_not_contained;\
+    return lagus_btree_##E##_remove_at (btree, index, element);\
+}\
+\
+lagus_result lagus_btree_##E##_get_at (lagus_btree_##E * btree, uint64_t index, E * element) {\
+    uint64_t path [64];\
+    uint64_t positions [64];\
+    uint64_t leaf = lagus_btree_##E##_locate (btree, index, path, positions);\
+    * element = btree -> leaves [leaf].elements [positions [1]];\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_btree_iterator_##E##_initialize (lagus_btree_iterator_##E * iterator, lagus_btree_##E * btree) {\
+    * iterator = (lagus_btree_iterator_##E) {\
+        .leaf = btree -> first,\
+        .position = 0,\
+        .leaves = btree -> leaves\
+    };\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_btree_iterator_##E##_next (lagus_btree_iterator_##E * iterator, E * element) {\
+    if (! iterator -> leaf)\
+        return lagus_stop;\
+    lagus_btree_leaf_##E * leaf = iterator -> leaves + iterator -> leaf;\
+    * element = leaf -> elements [iterator -> position];\
+    iterator -> position ++;\
+    if (iterator -> position == leaf -> count) {\
+        iterator -> leaf = leaf -> next;\
+        iterator -> position = 0;\
+    }\
+    return lagus_success;\
+}\
+\
+lagus_result lagus_btree_iterator_##E##_finalize (lagus_btree_iterator_##E * iterator) {\
     return lagus_success;\
 }
 